@@ -0,0 +1,101 @@
+/**
+ * @file alloc.c
+ * @brief Implementação dos pools de objetos e da arena de temporários.
+ */
+#include "alloc.h"
+#include "common.h"
+
+#include <stdlib.h>
+
+// Cabeçalho de cada slab; os objetos começam ALLOC_ALIGN bytes depois
+struct slab {
+    struct slab *next;
+};
+
+// Bloco avulso de uma arena
+struct arena_chunk {
+    struct arena_chunk *next;
+};
+
+void *pool_alloc(struct pool *p) {
+    if (p->free_list == NULL) {
+        struct slab *slab = malloc(ALLOC_ALIGN + p->objsize * p->per_slab);
+        if (slab == NULL) {
+            logexit("malloc");
+        }
+        slab->next = p->slabs;
+        p->slabs = slab;
+        p->nslabs++;
+
+        // Encadeia os objetos do novo slab na lista livre
+        char *objs = (char *)slab + ALLOC_ALIGN;
+        for (size_t i = p->per_slab; i-- > 0;) {
+            void **obj = (void **)(objs + i * p->objsize);
+            *obj = p->free_list;
+            p->free_list = obj;
+        }
+    }
+
+    void **obj = p->free_list;
+    p->free_list = *obj;
+    p->allocs++;
+    return obj;
+}
+
+void pool_free(struct pool *p, void *obj) {
+    *(void **)obj = p->free_list;
+    p->free_list = obj;
+    p->frees++;
+}
+
+void *arena_alloc(struct arena *a, size_t size) {
+    size = ALLOC_ROUND(size);
+    if (a->base == NULL) {
+        a->base = malloc(a->size);
+        if (a->base == NULL) {
+            logexit("malloc");
+        }
+    }
+
+    void *p;
+    if (a->used + size <= a->size) {
+        p = a->base + a->used;
+        a->used += size;
+    } else {
+        // Não cabe no bloco: usa um bloco avulso até o próximo reset
+        struct arena_chunk *chunk = malloc(ALLOC_ALIGN + size);
+        if (chunk == NULL) {
+            logexit("malloc");
+        }
+        chunk->next = a->extra;
+        a->extra = chunk;
+        a->extra_bytes += size;
+        a->overflows++;
+        p = (char *)chunk + ALLOC_ALIGN;
+    }
+
+    if (a->used + a->extra_bytes > a->peak) {
+        a->peak = a->used + a->extra_bytes;
+    }
+    return p;
+}
+
+void arena_reset(struct arena *a) {
+    a->resets++;
+    a->used = 0;
+    if (a->extra == NULL) {
+        return;
+    }
+
+    while (a->extra) {
+        struct arena_chunk *chunk = a->extra;
+        a->extra = chunk->next;
+        free(chunk);
+    }
+
+    // Cresce o bloco para que o mesmo padrão de uso caiba nele da próxima vez
+    a->size += a->extra_bytes;
+    a->extra_bytes = 0;
+    free(a->base);
+    a->base = NULL;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file alloc.h
+ * @brief Arquivo de cabeçalho dos alocadores do núcleo do jogo.
+ *
+ * Este arquivo define dois alocadores usados no caminho de processamento dos
+ * comandos, de modo que, em regime, nenhum comando chama malloc() ou free():
+ *
+ * - pool: objetos de tamanho fixo (sessões, salas, frames, nós das filas)
+ *   tirados de slabs com uma lista livre intrusiva. Os slabs nunca são
+ *   devolvidos ao sistema.
+ * - arena: memória temporária obtida por incremento de ponteiro e liberada de
+ *   uma só vez em arena_reset(), uma vez por comando.
+ *
+ * Nenhum dos dois é sincronizado: cada instância pertence a uma única thread
+ * (a do laço de eventos, no servidor).
+ */
+#pragma once
+
+#include <stddef.h>
+
+// Alinhamento dos objetos entregues pelos alocadores
+#define ALLOC_ALIGN 16
+// Arredonda n para o próximo múltiplo de ALLOC_ALIGN
+#define ALLOC_ROUND(n) (((n) + ALLOC_ALIGN - 1) & ~(size_t)(ALLOC_ALIGN - 1))
+
+/**
+ * @brief Pool de objetos de tamanho fixo.
+ */
+struct pool {
+    const char *name;           // Nome exibido nas estatísticas
+    size_t objsize;             // Tamanho de cada objeto (alinhado)
+    size_t per_slab;            // Objetos por slab
+    void *free_list;            // Objetos livres
+    void *slabs;                // Slabs alocados (lista ligada)
+    unsigned long long allocs;  // Objetos entregues
+    unsigned long long frees;   // Objetos devolvidos
+    unsigned long long nslabs;  // Slabs alocados (chamadas a malloc)
+};
+
+// Inicializador estático de um pool
+#define POOL_INITIALIZER(name, objsize, per_slab)                             \
+    { name, ALLOC_ROUND(objsize), per_slab, NULL, NULL, 0, 0, 0 }
+
+/**
+ * @brief Obtém um objeto do pool, alocando um novo slab se necessário.
+ *
+ * O conteúdo do objeto não é inicializado.
+ */
+void *pool_alloc(struct pool *p);
+
+/**
+ * @brief Devolve um objeto ao pool.
+ */
+void pool_free(struct pool *p, void *obj);
+
+/**
+ * @brief Área de memória temporária liberada de uma só vez.
+ *
+ * Pedidos que não cabem no bloco atual são atendidos por malloc() e contados
+ * em overflows; no próximo arena_reset() o bloco cresce para acomodá-los.
+ */
+struct arena {
+    char *base;                   // Bloco atual (alocado no primeiro uso)
+    size_t size;                  // Tamanho do bloco
+    size_t used;                  // Bytes em uso desde o último reset
+    size_t peak;                  // Maior uso entre dois resets
+    void *extra;                  // Blocos avulsos dos pedidos excedentes
+    size_t extra_bytes;           // Bytes nos blocos avulsos
+    unsigned long long resets;    // Chamadas a arena_reset()
+    unsigned long long overflows; // Pedidos que não couberam no bloco
+};
+
+// Inicializador estático de uma arena com bloco inicial de size bytes
+#define ARENA_INITIALIZER(size) { NULL, size, 0, 0, NULL, 0, 0, 0 }
+
+/**
+ * @brief Obtém size bytes não inicializados da arena.
+ */
+void *arena_alloc(struct arena *a, size_t size);
+
+/**
+ * @brief Libera tudo o que foi obtido da arena desde o último reset.
+ */
+void arena_reset(struct arena *a);
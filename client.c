@@ -5,11 +5,14 @@
  * Este arquivo contém a implementação do cliente do jogo de labirinto,
  * responsável por estabelecer conexão com o servidor, enviar comandos
  * e receber/exibir as respostas. O cliente gerencia a interface com o
- * usuário e mantém o estado do jogo localmente.
+ * usuário e mantém o estado do jogo localmente. Avisos assíncronos do
+ * servidor (posições dos jogadores de uma sala) são exibidos assim que
+ * chegam, mesmo enquanto o cliente aguarda um comando.
  */
 
 #include "common.h"
 #include <arpa/inet.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,6 +25,8 @@ int game_won = 0;
 
 // Tamanho máximo do buffer de mensagens
 #define BUFSZ 1024
+// Tamanho do buffer de recepção (avisos de salas grandes podem ser longos)
+#define RECVSZ 65536
 
 /**
  * @brief Exibe a mensagem de uso do programa e encerra a execução.
@@ -47,6 +52,77 @@ struct action {
     int board[10][10];     // Estado do tabuleiro
 };
 
+/**
+ * @brief Copia uma mensagem do servidor expandindo o mapa codificado em
+ * run-length (MAP_RLE_TAG), se houver, para o formato texto.
+ *
+ * @param msg Mensagem recebida.
+ * @param out Buffer de tamanho RECVSZ onde a mensagem será armazenada.
+ */
+void expand_message(const char *msg, char *out) {
+    const char *tag = strstr(msg, MAP_RLE_TAG);
+    size_t prefix = tag ? (size_t)(tag - msg) : 0;
+    if (tag == NULL || prefix >= RECVSZ ||
+        map_rle_decode(tag, out + prefix, RECVSZ - prefix) != 0) {
+        snprintf(out, RECVSZ, "%s", msg); // Mensagem sem mapa codificado
+        return;
+    }
+    memcpy(out, msg, prefix);
+}
+
+// Bytes recebidos do servidor ainda não processados
+char rbuf[RECVSZ];
+size_t rlen = 0;
+
+/**
+ * @brief Recebe dados do servidor e trata as mensagens completas.
+ *
+ * Cada mensagem termina em '\0'. Avisos assíncronos (iniciados por
+ * NOTICE_PREFIX, como as posições dos jogadores de uma sala) são exibidos
+ * imediatamente; a resposta a um comando é copiada para response. Mapas
+ * codificados em run-length são expandidos antes.
+ *
+ * @param s Socket conectado ao servidor.
+ * @param response Buffer de tamanho RECVSZ para a resposta, ou NULL.
+ * @return 1 se uma resposta foi copiada para response, 0 caso contrário.
+ */
+int receive_messages(int s, char *response) {
+    ssize_t count = recv(s, rbuf + rlen, RECVSZ - rlen, 0);
+    if (count <= 0) {
+        printf("server closed the connection\n");
+        close(s);
+        exit(EXIT_FAILURE);
+    }
+    rlen += count;
+
+    int got_response = 0;
+    size_t start = 0;
+    for (size_t i = 0; i < rlen; i++) {
+        if (rbuf[i] != '\0') {
+            continue;
+        }
+        char *msg = rbuf + start;
+        if (strncmp(msg, NOTICE_PREFIX, strlen(NOTICE_PREFIX)) == 0) {
+            static char notice[RECVSZ];
+            expand_message(msg, notice);
+            printf("\n%s\n", notice);
+            fflush(stdout);
+        } else if (response != NULL && !got_response) {
+            expand_message(msg, response);
+            got_response = 1;
+        }
+        start = i + 1;
+    }
+
+    // Descarta mensagens maiores que o buffer
+    if (start == 0 && rlen == RECVSZ) {
+        start = rlen;
+    }
+    memmove(rbuf, rbuf + start, rlen - start);
+    rlen -= start;
+    return got_response;
+}
+
 /**
  * @brief Função principal do cliente.
  *
@@ -84,11 +160,46 @@ int main(int argc, char **argv) {
         logexit("connect");
     }
 
+    // Pede os mapas codificados em run-length; servidores que não conhecem
+    // o comando respondem com erro e continuam enviando texto
+    const char *negotiate = "encoding rle";
+    if (send(s, negotiate, strlen(negotiate) + 1, 0) !=
+        (ssize_t)strlen(negotiate) + 1) {
+        logexit("send");
+    }
+    static char reply[RECVSZ];
+    while (!receive_messages(s, reply)) {
+        // Aguarda a resposta da negociação
+    }
+    if (strcmp(reply, "error: server busy") == 0) {
+        printf("%s\n", reply);
+        close(s);
+        exit(EXIT_FAILURE);
+    }
+
+    // A entrada padrão é lida sem buffer para que poll() enxergue todas as
+    // linhas ainda não lidas, inclusive quando chegam várias de uma vez
+    setvbuf(stdin, NULL, _IONBF, 0);
+
     // Loop principal do cliente
     while (1) {
+        // Aguarda um comando do usuário, exibindo os avisos do servidor
+        struct pollfd pfds[2] = {{STDIN_FILENO, POLLIN, 0}, {s, POLLIN, 0}};
+        if (poll(pfds, 2, -1) < 0) {
+            logexit("poll");
+        }
+        if (pfds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            receive_messages(s, NULL);
+        }
+        if (!(pfds[0].revents & (POLLIN | POLLHUP))) {
+            continue;
+        }
+
         // Lê comando do usuário
         char cmd[BUFSZ];
-        fgets(cmd, BUFSZ - 1, stdin);
+        if (fgets(cmd, BUFSZ - 1, stdin) == NULL) {
+            break; // Fim da entrada padrão
+        }
         cmd[strcspn(cmd, "\n")] = 0;  // Remove o caractere de nova linha
 
         // Se o jogo foi vencido, aceita apenas 'reset' ou 'exit'
@@ -100,11 +211,17 @@ int main(int argc, char **argv) {
         if (strcmp(cmd, "start") == 0 || strcmp(cmd, "right") == 0 ||
             strcmp(cmd, "left") == 0 || strcmp(cmd, "up") == 0 ||
             strcmp(cmd, "down") == 0 || strcmp(cmd, "map") == 0 ||
-            strcmp(cmd, "hint") == 0 || strcmp(cmd, "reset") == 0 ||
-            strcmp(cmd, "exit") == 0) {
+            strcmp(cmd, "hint") == 0 || strncmp(cmd, "hint ", 5) == 0 ||
+            strncmp(cmd, "door ", 5) == 0 || strcmp(cmd, "reset") == 0 ||
+            strncmp(cmd, "join ", 5) == 0 || strcmp(cmd, "exit") == 0 ||
+            strcmp(cmd, "whoami") == 0 || strncmp(cmd, "watch ", 6) == 0 ||
+            strcmp(cmd, "unwatch") == 0 || strcmp(cmd, "stats") == 0) {
 
-            // Verifica se o jogo foi iniciado
-            if (!game_active && strcmp(cmd, "start") != 0) {
+            // Verifica se o jogo foi iniciado (espectadores não precisam)
+            if (!game_active && strcmp(cmd, "start") != 0 &&
+                strncmp(cmd, "join ", 5) != 0 && strcmp(cmd, "whoami") != 0 &&
+                strncmp(cmd, "watch ", 6) != 0 && strcmp(cmd, "unwatch") != 0 &&
+                strcmp(cmd, "stats") != 0 && strcmp(cmd, "exit") != 0) {
                 printf("error: start the game first\n");
                 continue;
             }
@@ -116,27 +233,31 @@ int main(int argc, char **argv) {
             }
 
             // Recebe a resposta do servidor
-            char buf[BUFSZ];
-            memset(buf, 0, BUFSZ);
-            count = recv(s, buf, BUFSZ - 1, 0);
+            char buf[RECVSZ];
+            while (!receive_messages(s, buf)) {
+                // Avisos recebidos antes da resposta já foram exibidos
+            }
 
-            if (count > 0) {
-                // Exibe a resposta do servidor
-                printf("\n%s\n", buf);
+            // Exibe a resposta do servidor
+            printf("\n%s\n", buf);
 
-                // Atualiza o estado do jogo com base no comando
-                if (strcmp(cmd, "start") == 0) {
+            // Atualiza o estado do jogo com base no comando
+            if (strcmp(cmd, "start") == 0) {
+                game_active = 1;
+                game_won = 0;
+            } else if (strncmp(cmd, "join ", 5) == 0) {
+                if (strncmp(buf, "error", 5) != 0) {
                     game_active = 1;
                     game_won = 0;
-                } else if (strcmp(cmd, "exit") == 0) {
-                    close(s);
-                    exit(EXIT_SUCCESS);
-                } else if (strcmp(cmd, "reset") == 0) {
-                    game_won = 0;    // Reseta o estado de vitória
-                    game_active = 1; // Reativa o jogo
-                } else if (strstr(buf, "You escaped!") != NULL) {
-                    game_won = 1;    // Marca o jogo como vencido
                 }
+            } else if (strcmp(cmd, "exit") == 0) {
+                close(s);
+                exit(EXIT_SUCCESS);
+            } else if (strcmp(cmd, "reset") == 0) {
+                game_won = 0;    // Reseta o estado de vitória
+                game_active = 1; // Reativa o jogo
+            } else if (strstr(buf, "You escaped!") != NULL) {
+                game_won = 1;    // Marca o jogo como vencido
             }
         } else {
             // Comando inválido
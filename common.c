@@ -105,3 +105,65 @@ int server_sockaddr_init(const char *proto, const char *portstr,
         return -1;
     }
 }
+
+size_t map_rle_encode(const char *glyphs, int size, char *out,
+                      size_t outsize) {
+    int total = size * size;
+    size_t len = snprintf(out, outsize, "%s%d ", MAP_RLE_TAG, size);
+
+    for (int i = 0; i < total && len < outsize;) {
+        int run = 1;
+        while (i + run < total && glyphs[i + run] == glyphs[i]) {
+            run++;
+        }
+        if (run == 1) {
+            len += snprintf(out + len, outsize - len, "%c", glyphs[i]);
+        } else {
+            len += snprintf(out + len, outsize - len, "%c%d", glyphs[i], run);
+        }
+        i += run;
+    }
+    return len < outsize ? len : outsize - 1;
+}
+
+int map_rle_decode(const char *in, char *out, size_t outsize) {
+    size_t taglen = strlen(MAP_RLE_TAG);
+    if (strncmp(in, MAP_RLE_TAG, taglen) != 0) {
+        return -1;
+    }
+
+    char *end;
+    long size = strtol(in + taglen, &end, 10);
+    if (size <= 0 || size > 1024 || *end != ' ') {
+        return -1;
+    }
+    const char *p = end + 1;
+
+    // Cada célula ocupa 2 caracteres e cada linha termina em '\n'
+    if ((size_t)(size * (2 * size + 1)) >= outsize) {
+        return -1;
+    }
+
+    long cell = 0;
+    size_t len = 0;
+    while (*p != '\0' && cell < size * size) {
+        char glyph = *p++;
+        long run = 1;
+        if (*p >= '0' && *p <= '9') {
+            run = strtol(p, &end, 10);
+            p = end;
+        }
+        if (run <= 0 || cell + run > size * size) {
+            return -1;
+        }
+        for (long k = 0; k < run; k++, cell++) {
+            out[len++] = glyph;
+            out[len++] = '\t';
+            if ((cell + 1) % size == 0) {
+                out[len++] = '\n';
+            }
+        }
+    }
+    out[len] = '\0';
+    return cell == size * size ? 0 : -1;
+}
@@ -12,6 +12,19 @@
 #include <stdlib.h>
 #include <arpa/inet.h>
 
+// Prefixo das mensagens que o servidor envia sem que um comando as solicite
+#define NOTICE_PREFIX "["
+
+// Codificações do mapa negociadas por conexão (comando "encoding <nome>")
+enum map_encoding {
+    MAP_ENCODING_TEXT, // Um caractere e um tab por célula, uma linha por fila
+    MAP_ENCODING_RLE,  // Sequências de caracteres iguais (run-length)
+    MAP_ENCODING_COUNT
+};
+
+// Marca o início de um mapa codificado em run-length dentro de uma mensagem
+#define MAP_RLE_TAG "@rle "
+
 /**
  * @brief Função para registrar um erro e encerrar o programa.
  * 
@@ -50,4 +63,30 @@ void addrtostr(const struct sockaddr *addr, char *str, size_t strsize);
  * @return 0 em caso de sucesso, -1 em caso de erro.
  */
 int server_sockaddr_init(const char *proto, const char *portstr,
-                         struct sockaddr_storage *storage);
\ No newline at end of file
+                         struct sockaddr_storage *storage);
+
+/**
+ * @brief Codifica o mapa em run-length.
+ *
+ * A saída é MAP_RLE_TAG, o lado do tabuleiro, um espaço e as sequências de
+ * células em ordem por linhas, cada uma como o caractere da célula seguido
+ * da quantidade (omitida quando é 1). Ex.: "@rle 5 +_?3#5?15".
+ *
+ * @param glyphs Caracteres das células, size * size em ordem por linhas.
+ * @param size Lado do tabuleiro.
+ * @param out Buffer onde a string codificada será armazenada.
+ * @param outsize Tamanho do buffer.
+ * @return Número de caracteres escritos (sem o '\0').
+ */
+size_t map_rle_encode(const char *glyphs, int size, char *out,
+                      size_t outsize);
+
+/**
+ * @brief Decodifica um mapa gerado por map_rle_encode() para o formato texto.
+ *
+ * @param in String iniciada por MAP_RLE_TAG.
+ * @param out Buffer onde o mapa em texto será armazenado.
+ * @param outsize Tamanho do buffer.
+ * @return 0 em caso de sucesso, -1 se a entrada for inválida ou não couber.
+ */
+int map_rle_decode(const char *in, char *out, size_t outsize);
\ No newline at end of file
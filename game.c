@@ -0,0 +1,1361 @@
+/**
+ * @file game.c
+ * @brief Implementação do núcleo do jogo: sessões, salas e comandos.
+ *
+ * Este arquivo implementa o processamento dos comandos dos clientes, as salas
+ * compartilhadas (comando join), onde as posições dos jogadores são
+ * transmitidas em um único frame por tick para todos os membros, e o modo
+ * espectador (comando watch), em que o mapa de uma sessão é enviado a cada
+ * mudança de estado.
+ */
+#include "game.h"
+#include "common.h"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Estado global do jogo
+struct session *sessions[MAX_SESSIONS];
+int nsessions = 0;
+int next_session_id = 1;
+struct room *rooms = NULL;
+const char *map_file = MAP_FILE;
+int game_verbose = 1;
+struct journal *game_journal = NULL;
+
+int game_idle_timeout = 300;
+int game_time_limit = 0;
+int map_reload_interval = 5;
+int game_rate_limit = 50;
+int game_max_sessions = MAX_SESSIONS;
+
+// Instante do último tick, em milissegundos
+long long game_now_ms = 0;
+// Bytes pendentes nas filas de saída de todas as sessões
+size_t game_out_bytes = 0;
+// Contadores de sobrecarga
+unsigned long long full_queues = 0;        // Filas que atingiram o limite
+unsigned long long deferred_commands = 0;  // Comandos que esperaram
+unsigned long long shed_frames = 0;        // Transmissões descartadas
+unsigned long long shed_connections = 0;   // Conexões recusadas
+
+// Mapa lido do arquivo uma única vez e copiado para cada nova sala
+struct maze map_template;
+int map_template_loaded = 0;
+// Instante de modificação do arquivo quando o mapa foi lido
+struct timespec map_mtime;
+
+// Temporizadores do jogo, com resolução de TICK_MS
+struct timer_wheel game_timers;
+// Verificação periódica do arquivo do mapa
+struct timer map_timer;
+
+// Alocadores do núcleo, usados apenas pela thread do laço de eventos
+struct pool session_pool =
+    POOL_INITIALIZER("session", sizeof(struct session), 16);
+struct pool room_pool = POOL_INITIALIZER("room", sizeof(struct room), 16);
+struct pool outbuf_pool =
+    POOL_INITIALIZER("outbuf", sizeof(struct outbuf), 256);
+struct pool door_timer_pool =
+    POOL_INITIALIZER("door-timer", sizeof(struct door_timer), 32);
+// Frames por classe de tamanho do conteúdo
+// (a maior comporta a transmissão de uma sala com MAX_SESSIONS jogadores)
+const size_t frame_class_size[FRAME_CLASSES] = {64, 256, BUFSZ, 4096, 32768};
+struct pool frame_pools[FRAME_CLASSES] = {
+    POOL_INITIALIZER("frame-64", sizeof(struct frame) + 64, 256),
+    POOL_INITIALIZER("frame-256", sizeof(struct frame) + 256, 64),
+    POOL_INITIALIZER("frame-1024", sizeof(struct frame) + BUFSZ, 16),
+    POOL_INITIALIZER("frame-4096", sizeof(struct frame) + 4096, 8),
+    POOL_INITIALIZER("frame-32768", sizeof(struct frame) + 32768, 2),
+};
+// Frames grandes demais para os pools, alocados com malloc()
+unsigned long long heap_frames = 0;
+// Temporários de um comando, liberados no início do próximo
+struct arena command_arena = ARENA_INITIALIZER(COMMAND_ARENA_SIZE);
+
+/**
+ * @brief Escreve uma mensagem de acompanhamento em stdout.
+ */
+void game_log(const char *fmt, ...) {
+    if (!game_verbose) {
+        return;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+/**
+ * @brief Aloca um frame com espaço para len bytes e uma referência.
+ *
+ * O frame vem do pool da menor classe em que cabe; apenas frames maiores que
+ * todas as classes são alocados com malloc().
+ */
+struct frame *frame_alloc(size_t len) {
+    struct pool *p = NULL;
+    for (int i = 0; i < FRAME_CLASSES && p == NULL; i++) {
+        if (len <= frame_class_size[i]) {
+            p = &frame_pools[i];
+        }
+    }
+
+    struct frame *f;
+    if (p) {
+        f = pool_alloc(p);
+    } else {
+        f = malloc(sizeof(struct frame) + len);
+        if (f == NULL) {
+            logexit("malloc");
+        }
+        heap_frames++;
+    }
+    f->pool = p;
+    f->refs = 1;
+    f->len = len;
+    return f;
+}
+
+/**
+ * @brief Libera uma referência a um frame, desalocando-o na última.
+ */
+void frame_release(struct frame *f) {
+    if (--f->refs != 0) {
+        return;
+    }
+    if (f->pool) {
+        pool_free(f->pool, f);
+    } else {
+        free(f);
+    }
+}
+
+/**
+ * @brief Coloca um frame na fila de saída de uma sessão.
+ *
+ * A sessão passa a manter sua própria referência ao frame; o conteúdo não é
+ * copiado.
+ */
+void session_enqueue(struct session *s, struct frame *f) {
+    if (s->dead) {
+        return;
+    }
+    struct outbuf *node = pool_alloc(&outbuf_pool);
+    f->refs++;
+    node->frame = f;
+    node->next = NULL;
+    if (s->out_tail) {
+        s->out_tail->next = node;
+    } else {
+        s->out_head = node;
+    }
+    s->out_tail = node;
+    s->out_count++;
+
+    if (s->out_bytes < OUT_QUEUE_MAX_BYTES &&
+        s->out_bytes + f->len >= OUT_QUEUE_MAX_BYTES) {
+        full_queues++;
+    }
+    s->out_bytes += f->len;
+    game_out_bytes += f->len;
+}
+
+/**
+ * @brief Retira o primeiro frame da fila de saída de uma sessão.
+ */
+void session_dequeue(struct session *s) {
+    struct outbuf *node = s->out_head;
+    s->out_head = node->next;
+    if (s->out_head == NULL) {
+        s->out_tail = NULL;
+    }
+    s->out_offset = 0;
+    s->out_count--;
+    s->out_bytes -= node->frame->len;
+    game_out_bytes -= node->frame->len;
+    frame_release(node->frame);
+    pool_free(&outbuf_pool, node);
+}
+
+/**
+ * @brief Envia uma mensagem de texto (terminada em '\0') para uma sessão.
+ */
+void session_send_text(struct session *s, const char *msg) {
+    size_t len = strlen(msg) + 1;
+    struct frame *f = frame_alloc(len);
+    memcpy(f->data, msg, len);
+    session_enqueue(s, f);
+    frame_release(f);
+}
+
+int session_flush(struct session *s) {
+    while (s->out_head && s->fd < 0) {
+        session_dequeue(s);
+    }
+
+    while (s->out_head) {
+        struct frame *f = s->out_head->frame;
+        ssize_t count = send(s->fd, f->data + s->out_offset,
+                             f->len - s->out_offset, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return 0;
+            }
+            return -1;
+        }
+        s->out_offset += count;
+        if (s->out_offset < f->len) {
+            return 0;
+        }
+        session_dequeue(s);
+    }
+    return 0;
+}
+
+/**
+ * @brief Converte segundos em ticks da roda de temporizadores.
+ */
+uint64_t seconds_to_ticks(int seconds) {
+    return (uint64_t)seconds * 1000 / TICK_MS;
+}
+
+/**
+ * @brief Relê o mapa se o arquivo mudou desde a última leitura.
+ *
+ * Apenas as salas criadas depois usam o novo mapa; um arquivo inválido é
+ * ignorado e o mapa anterior é mantido.
+ */
+void map_reload_check(struct timer *t) {
+    struct stat st;
+    if (stat(map_file, &st) == 0 && (st.st_mtim.tv_sec != map_mtime.tv_sec ||
+                                     st.st_mtim.tv_nsec != map_mtime.tv_nsec)) {
+        map_mtime = st.st_mtim;
+        struct maze m;
+        if (maze_load(&m, map_file) == 0) {
+            map_template = m;
+            game_log("map reloaded\n");
+        } else {
+            fprintf(stderr, "Failed to reload the map, keeping the old one\n");
+        }
+    }
+    timer_add(&game_timers, t, seconds_to_ticks(map_reload_interval));
+}
+
+/**
+ * @brief Procura uma sala compartilhada pelo nome.
+ */
+struct room *room_find(const char *name) {
+    for (struct room *r = rooms; r != NULL; r = r->next) {
+        if (r->name[0] != '\0' && strcmp(r->name, name) == 0) {
+            return r;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Cria uma sala com uma cópia do mapa.
+ *
+ * O arquivo do mapa é lido apenas na primeira vez; as salas seguintes copiam
+ * o mapa já validado, que é relido quando o arquivo muda (ver
+ * map_reload_check()).
+ *
+ * @param name Nome da sala (vazio para uma sala privada).
+ * @return Ponteiro para a sala, ou NULL se o mapa não pôde ser carregado.
+ */
+struct room *room_create(const char *name) {
+    if (!map_template_loaded) {
+        if (maze_load(&map_template, map_file) != 0) {
+            fprintf(stderr, "Failed to initialize game board\n");
+            return NULL;
+        }
+        map_template_loaded = 1;
+
+        struct stat st;
+        if (stat(map_file, &st) == 0) {
+            map_mtime = st.st_mtim;
+        }
+        if (map_reload_interval > 0) {
+            map_timer.fn = map_reload_check;
+            timer_add(&game_timers, &map_timer,
+                      seconds_to_ticks(map_reload_interval));
+        }
+    }
+    struct room *r = pool_alloc(&room_pool);
+    memset(r, 0, sizeof(struct room));
+    r->maze = map_template;
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->next = rooms;
+    if (rooms) {
+        rooms->prev = r;
+    }
+    rooms = r;
+    return r;
+}
+
+/**
+ * @brief Marca que as posições da sala mudaram.
+ *
+ * A sala é transmitida no próximo tick, e os espectadores de todos os
+ * membros recebem o novo estado, já que cada um deles vê os demais.
+ */
+void room_touch(struct room *r) {
+    r->dirty = 1;
+    for (struct session *o = r->members; o != NULL; o = o->room_next) {
+        o->watch_dirty = 1;
+    }
+}
+
+/**
+ * @brief Remove a sessão da sua sala, destruindo a sala se ficar vazia.
+ */
+void room_leave(struct session *s) {
+    struct room *r = s->room;
+    if (r == NULL) {
+        return;
+    }
+
+    if (s->room_prev) {
+        s->room_prev->room_next = s->room_next;
+    } else {
+        r->members = s->room_next;
+    }
+    if (s->room_next) {
+        s->room_next->room_prev = s->room_prev;
+    }
+    s->room = NULL;
+    s->room_prev = s->room_next = NULL;
+    r->nmembers--;
+    room_touch(r);
+    if (r->owner == s) {
+        r->owner = r->members; // A posse passa para outro membro
+    }
+
+    if (r->nmembers == 0) {
+        while (r->door_timers) {
+            struct door_timer *dt = r->door_timers;
+            r->door_timers = dt->next;
+            timer_cancel(&game_timers, &dt->timer);
+            pool_free(&door_timer_pool, dt);
+        }
+        if (r->prev) {
+            r->prev->next = r->next;
+        } else {
+            rooms = r->next;
+        }
+        if (r->next) {
+            r->next->prev = r->prev;
+        }
+        pool_free(&room_pool, r);
+    }
+}
+
+/**
+ * @brief Adiciona a sessão a uma sala.
+ */
+void room_enter(struct session *s, struct room *r) {
+    s->room = r;
+    s->room_prev = NULL;
+    s->room_next = r->members;
+    if (r->members) {
+        r->members->room_prev = s;
+    }
+    r->members = s;
+    r->nmembers++;
+    room_touch(r);
+    if (r->owner == NULL) {
+        r->owner = s;
+    }
+}
+
+/**
+ * @brief Verifica se algum jogador da sala ocupa a célula (x, y).
+ */
+int room_occupied(const struct room *r, int x, int y) {
+    for (struct session *o = r->members; o != NULL; o = o->room_next) {
+        if (o->game_started && o->player_x == x && o->player_y == y) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Abre ou fecha uma porta da sala e avisa os espectadores.
+ *
+ * @return 0 em caso de sucesso, -1 se há um jogador sobre a porta.
+ */
+int room_toggle_door(struct room *r, int cell) {
+    if (room_occupied(r, cell_x(cell), cell_y(cell))) {
+        return -1;
+    }
+    maze_toggle_door(&r->maze, cell);
+    for (struct session *o = r->members; o != NULL; o = o->room_next) {
+        o->watch_dirty = 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Troca uma porta com troca periódica e agenda a próxima troca.
+ *
+ * Se houver um jogador sobre a porta, ela fica como está até a próxima vez.
+ */
+void door_timer_expired(struct timer *t) {
+    struct door_timer *dt = t->arg;
+    room_toggle_door(dt->room, dt->cell);
+    timer_add(&game_timers, t, seconds_to_ticks(dt->period));
+}
+
+/**
+ * @brief Agenda a troca periódica de uma porta da sala.
+ *
+ * @param r Sala.
+ * @param cell Índice da porta.
+ * @param period Intervalo entre trocas em segundos (0 cancela a troca).
+ */
+void room_schedule_door(struct room *r, int cell, int period) {
+    struct door_timer **link = &r->door_timers;
+    while (*link && (*link)->cell != cell) {
+        link = &(*link)->next;
+    }
+    struct door_timer *dt = *link;
+
+    if (period == 0) {
+        if (dt) {
+            *link = dt->next;
+            timer_cancel(&game_timers, &dt->timer);
+            pool_free(&door_timer_pool, dt);
+        }
+        return;
+    }
+
+    if (dt == NULL) {
+        dt = pool_alloc(&door_timer_pool);
+        memset(dt, 0, sizeof(struct door_timer));
+        dt->timer.fn = door_timer_expired;
+        dt->timer.arg = dt;
+        dt->room = r;
+        dt->cell = cell;
+        dt->next = r->door_timers;
+        r->door_timers = dt;
+    }
+    dt->period = period;
+    timer_add(&game_timers, &dt->timer, seconds_to_ticks(period));
+}
+
+/**
+ * @brief Marca como descobertas a célula (x, y) e suas vizinhas.
+ *
+ * @param s Sessão do jogador.
+ * @param x Coordenada x da célula central.
+ * @param y Coordenada y da célula central.
+ */
+void discover_around(struct session *s, int x, int y) {
+    int size = s->room->maze.size;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int ny = y + dy;
+            int nx = x + dx;
+            if (ny >= 0 && ny < size && nx >= 0 && nx < size) {
+                s->discovered[cell_index(nx, ny)] = 1;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Encerra a partida de uma sessão que atingiu o tempo limite.
+ */
+void game_time_expired(struct timer *t) {
+    struct session *s = t->arg;
+    if (!s->game_started || s->game_completed) {
+        return;
+    }
+    s->game_started = 0;
+    room_touch(s->room);
+
+    char notice[64];
+    snprintf(notice, sizeof(notice), "[game] time is up after %d s",
+             game_time_limit);
+    session_send_text(s, notice);
+    game_log("player #%d ran out of time\n", s->id);
+}
+
+/**
+ * @brief Fecha uma sessão que passou game_idle_timeout segundos sem enviar
+ * comandos.
+ *
+ * Espectadores não expiram. Uma sessão que já estava fechando e ainda não
+ * esvaziou a fila de saída (cliente que não lê) é descartada.
+ */
+void session_idle_expired(struct timer *t) {
+    struct session *s = t->arg;
+    if (s->closing) {
+        s->dead = 1;
+        return;
+    }
+    if (s->watching == NULL) {
+        char notice[64];
+        snprintf(notice, sizeof(notice),
+                 "[server] closing idle connection after %d s",
+                 game_idle_timeout);
+        session_send_text(s, notice);
+        s->closing = 1;
+        game_log("client #%d timed out\n", s->id);
+    }
+    timer_add(&game_timers, t, seconds_to_ticks(game_idle_timeout));
+}
+
+/**
+ * @brief Inicia uma partida na sala atual da sessão.
+ *
+ * Posiciona o jogador na entrada e configura as células descobertas
+ * inicialmente ao redor dela.
+ *
+ * @param s Sessão do jogador.
+ */
+void init_board(struct session *s) {
+    memset(s->discovered, 0, sizeof(s->discovered));
+
+    // Marca a posição inicial e células adjacentes como descobertas
+    s->player_x = s->room->maze.entrance_x;
+    s->player_y = s->room->maze.entrance_y;
+    discover_around(s, s->player_x, s->player_y);
+
+    s->game_started = 1;
+    s->game_completed = 0;
+    room_touch(s->room);
+
+    if (game_time_limit > 0) {
+        timer_add(&game_timers, &s->game_timer,
+                  seconds_to_ticks(game_time_limit));
+    }
+}
+
+/**
+ * @brief Inicia uma partida individual em uma sala nova, com o mapa original.
+ *
+ * @param s Sessão do jogador.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int start_private_game(struct session *s) {
+    room_leave(s);
+    struct room *r = room_create("");
+    if (r == NULL) {
+        s->game_started = 0;
+        return -1;
+    }
+    room_enter(s, r);
+    init_board(s);
+    return 0;
+}
+
+/**
+ * @brief Obtém o caractere de representação para uma célula do tabuleiro.
+ *
+ * @param s Sessão do jogador que verá o mapa.
+ * @param cell_type Tipo da célula (WALL, PATH, etc.).
+ * @param x Coordenada x da célula.
+ * @param y Coordenada y da célula.
+ * @param show_full_map Se diferente de zero, ignora as células não
+ *                      descobertas.
+ * @param others Marca as células ocupadas por outros jogadores da sala.
+ * @return Caractere que representa a célula.
+ */
+char get_cell_char(const struct session *s, int cell_type, int x, int y,
+                   int show_full_map, const unsigned char *others) {
+    if (x == s->player_x && y == s->player_y &&
+        (show_full_map || s->discovered[cell_index(x, y)])) {
+        if (cell_type == EXIT) {
+            return 'X';
+        }
+        return '+';
+    }
+
+    if (others[cell_index(x, y)]) {
+        return 'P';
+    }
+
+    if (!show_full_map && !s->discovered[cell_index(x, y)]) {
+        return '?';
+    }
+
+    switch (cell_type) {
+    case WALL:
+        return '#';
+    case PATH:
+        return '_';
+    case ENTRANCE:
+        return '>';
+    case EXIT:
+        return 'X';
+    case DOOR_CLOSED:
+        return 'D';
+    case DOOR_OPEN:
+        return 'd';
+    default:
+        return ' ';
+    }
+}
+
+// O mapa completo em texto cabe em uma mensagem
+_Static_assert(MAX_BOARD_SIZE * (2 * MAX_BOARD_SIZE + 1) + 1 <= BUFSZ,
+               "the text map must fit in BUFSZ");
+
+/**
+ * @brief Gera uma string representando o estado atual do tabuleiro.
+ *
+ * Os outros jogadores da sala aparecem como 'P'.
+ *
+ * @param s Sessão do jogador que verá o mapa.
+ * @param show_full_map Se diferente de zero, revela o mapa inteiro.
+ * @param encoding Codificação do mapa (enum map_encoding).
+ * @param map_str Buffer onde a string será armazenada.
+ * @param size Tamanho do buffer.
+ */
+void get_map_string(const struct session *s, int show_full_map, int encoding,
+                    char *map_str, size_t size) {
+    const struct maze *m = &s->room->maze;
+    unsigned char others[BOARD_CELLS] = {0};
+    for (struct session *o = s->room->members; o != NULL; o = o->room_next) {
+        if (o != s && o->game_started) {
+            others[cell_index(o->player_x, o->player_y)] = 1;
+        }
+    }
+
+    char glyphs[BOARD_CELLS];
+    char *g = glyphs;
+    for (int i = 0; i < m->size; i++) {
+        for (int j = 0; j < m->size; j++) {
+            *g++ = get_cell_char(s, maze_cell(m, j, i), j, i, show_full_map,
+                                 others);
+        }
+    }
+
+    if (encoding == MAP_ENCODING_RLE) {
+        map_rle_encode(glyphs, m->size, map_str, size);
+        return;
+    }
+
+    // Cada célula ocupa 2 caracteres e cada linha termina em '\n'; linhas que
+    // não cabem em size são omitidas
+    size_t row_len = 2 * m->size + 1;
+    size_t len = 0;
+    g = glyphs;
+    for (int i = 0; i < m->size && len + row_len < size; i++) {
+        for (int j = 0; j < m->size; j++) {
+            map_str[len++] = *g++;
+            map_str[len++] = '\t';
+        }
+        map_str[len++] = '\n';
+    }
+    if (size > 0) {
+        map_str[len] = '\0';
+    }
+}
+
+/**
+ * @brief Obtém os movimentos possíveis a partir da posição atual.
+ *
+ * @param m Labirinto.
+ * @param x Coordenada x atual.
+ * @param y Coordenada y atual.
+ * @param moves Buffer onde a string de movimentos será armazenada.
+ */
+void get_possible_moves(const struct maze *m, int x, int y, char *moves) {
+    strcpy(moves, "possible moves: ");
+    int first_move = 1;
+    int cell = cell_index(x, y);
+
+    // Verifica movimentos possíveis em ordem horária começando por cima
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        int next = maze_neighbor(m, cell, dir);
+        if (next >= 0 && maze_walkable(m, next)) {
+            if (!first_move)
+                strcat(moves, ", ");
+            strcat(moves, dir_names[dir]);
+            first_move = 0;
+        }
+    }
+}
+
+/**
+ * @brief Converte um comando de movimento em direção.
+ *
+ * @param cmd Comando recebido do cliente.
+ * @return Direção correspondente, ou -1 se cmd não for um movimento.
+ */
+int parse_direction(const char *cmd) {
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        if (strcmp(cmd, dir_names[dir]) == 0) {
+            return dir;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Procura uma sessão conectada pelo identificador.
+ */
+struct session *session_find(int id) {
+    for (int i = 0; i < nsessions; i++) {
+        if (sessions[i]->id == id && !sessions[i]->dead) {
+            return sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Codifica o estado de uma sessão como visto pelos espectadores.
+ *
+ * @param s Sessão observada.
+ * @param encoding Codificação do mapa (enum map_encoding).
+ */
+struct frame *encode_watch_frame(const struct session *s, int encoding) {
+    // O estado é escrito direto no frame, sem cópia intermediária
+    struct frame *f = frame_alloc(BUFSZ);
+    char *text = f->data;
+    if (!s->game_started) {
+        snprintf(text, BUFSZ, "[watch #%d] waiting for the game", s->id);
+    } else {
+        int len = snprintf(text, BUFSZ, "[watch #%d] (%d, %d)\n", s->id,
+                           s->player_x, s->player_y);
+        get_map_string(s, 0, encoding, text + len, BUFSZ - len);
+    }
+    f->len = strlen(text) + 1;
+    return f;
+}
+
+/**
+ * @brief Obtém o último estado da sessão na codificação pedida, codificando-o
+ * na primeira vez em que é usado.
+ */
+struct frame *watch_frame_for(struct session *s, int encoding) {
+    if (s->watch_frame[encoding] == NULL) {
+        s->watch_frame[encoding] = encode_watch_frame(s, encoding);
+    }
+    return s->watch_frame[encoding];
+}
+
+/**
+ * @brief Libera os frames de estado da sessão em todas as codificações.
+ */
+void watch_frames_release(struct session *s) {
+    for (int e = 0; e < MAP_ENCODING_COUNT; e++) {
+        if (s->watch_frame[e]) {
+            frame_release(s->watch_frame[e]);
+            s->watch_frame[e] = NULL;
+        }
+    }
+}
+
+/**
+ * @brief Envia aos espectadores o novo estado de uma sessão.
+ *
+ * O estado é codificado uma única vez por codificação em uso e o mesmo frame
+ * é colocado na fila de todos os espectadores em dia. Espectadores com
+ * WATCH_QUEUE_MAX frames pendentes deixam de receber atualizações e passam a
+ * receber apenas keyframes periódicos (ver watch_keyframes()), o que limita a
+ * memória ocupada por espectadores lentos.
+ */
+void session_publish(struct session *s) {
+    s->watch_dirty = 0;
+    watch_frames_release(s);
+    if (s->watchers == NULL) {
+        return;
+    }
+
+    for (struct session *w = s->watchers; w != NULL; w = w->watch_next) {
+        if (w->out_count >= WATCH_QUEUE_MAX) {
+            w->lagging = 1;
+        }
+        if (!w->lagging) {
+            session_enqueue(w, watch_frame_for(s, w->encoding));
+        }
+    }
+}
+
+/**
+ * @brief Envia o último estado aos espectadores atrasados que já esvaziaram
+ * a fila, que voltam a receber todas as atualizações.
+ */
+void watch_keyframes(void) {
+    for (int i = 0; i < nsessions; i++) {
+        struct session *s = sessions[i];
+        for (struct session *w = s->watchers; w != NULL; w = w->watch_next) {
+            if (w->lagging && w->out_count == 0) {
+                session_enqueue(w, watch_frame_for(s, w->encoding));
+                w->lagging = 0;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Deixa de observar a sessão atual, se houver.
+ */
+void watch_stop(struct session *w) {
+    struct session *s = w->watching;
+    if (s == NULL) {
+        return;
+    }
+    if (w->watch_prev) {
+        w->watch_prev->watch_next = w->watch_next;
+    } else {
+        s->watchers = w->watch_next;
+    }
+    if (w->watch_next) {
+        w->watch_next->watch_prev = w->watch_prev;
+    }
+    w->watching = NULL;
+    w->watch_prev = w->watch_next = NULL;
+    w->lagging = 0;
+}
+
+/**
+ * @brief Passa a observar a sessão s, recebendo de imediato o estado atual.
+ */
+void watch_start(struct session *w, struct session *s) {
+    watch_stop(w);
+    w->watching = s;
+    w->watch_prev = NULL;
+    w->watch_next = s->watchers;
+    if (s->watchers) {
+        s->watchers->watch_prev = w;
+    }
+    s->watchers = w;
+    w->lagging = 0;
+    if (!s->watch_dirty) {
+        session_enqueue(w, watch_frame_for(s, w->encoding));
+    }
+}
+
+/**
+ * @brief Acrescenta texto formatado ao fim de um buffer.
+ *
+ * Texto que não cabe é truncado, e len nunca passa de size - 1, então as
+ * chamadas seguintes não escrevem além do buffer.
+ *
+ * @param out Buffer com len bytes já escritos.
+ * @param size Tamanho do buffer.
+ * @param len Bytes já escritos.
+ * @param fmt Formato, como em printf().
+ * @return Bytes escritos após a chamada.
+ */
+size_t buf_append(char *out, size_t size, size_t len, const char *fmt, ...) {
+    if (len + 1 >= size) {
+        return len;
+    }
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out + len, size - len, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+        return len;
+    }
+    len += n;
+    return len < size ? len : size - 1;
+}
+
+/**
+ * @brief Descreve os contadores dos alocadores, dos temporizadores e de
+ * sobrecarga do núcleo.
+ *
+ * @param out Buffer onde a descrição será armazenada.
+ * @param size Tamanho do buffer.
+ */
+void format_stats(char *out, size_t size) {
+    const struct pool *pools[] = {
+        &session_pool,   &room_pool,      &outbuf_pool,    &door_timer_pool,
+        &frame_pools[0], &frame_pools[1], &frame_pools[2], &frame_pools[3],
+        &frame_pools[4]};
+    out[0] = '\0';
+    size_t len = buf_append(out, size, 0, "sessions: %d", nsessions);
+    for (size_t i = 0; i < sizeof(pools) / sizeof(pools[0]); i++) {
+        const struct pool *p = pools[i];
+        len = buf_append(out, size, len,
+                         "\npool %s: %llu in use, %llu allocs, %llu slabs",
+                         p->name, p->allocs - p->frees, p->allocs, p->nslabs);
+    }
+    len = buf_append(
+        out, size, len,
+        "\narena: %zu bytes, peak %zu, %llu resets, %llu overflows"
+        "\nheap frames: %llu\ntimers: %lu pending"
+        "\nbackpressure: %zu bytes queued, %llu full queues, %llu "
+        "deferred commands, %llu shed frames, %llu shed connections",
+        command_arena.size, command_arena.peak, command_arena.resets,
+        command_arena.overflows, heap_frames, game_timers.pending,
+        game_out_bytes, full_queues, deferred_commands, shed_frames,
+        shed_connections);
+    if (game_journal) {
+        buf_append(out, size, len, "\njournal: %llu records, %llu dropped",
+                   game_journal->records, game_journal->dropped);
+    }
+}
+
+/**
+ * @brief Processa um comando recebido do cliente.
+ *
+ * Esta função interpreta e executa os comandos recebidos do cliente,
+ * atualizando o estado do jogo e gerando a resposta apropriada.
+ *
+ * @param s Sessão que enviou o comando.
+ * @param cmd Comando recebido do cliente.
+ * @param response Buffer onde a resposta será armazenada.
+ */
+void process_command(struct session *s, char *cmd, char *response) {
+    int dir = parse_direction(cmd);
+
+    if (strcmp(cmd, "start") == 0) {
+        game_log("starting new game\n");
+        // Verifica se a inicialização foi bem-sucedida
+        if (start_private_game(s) != 0) {
+            strcpy(response, ""); // Não envia resposta em caso de falha
+            return;
+        }
+        char *moves = arena_alloc(&command_arena, BUFSZ);
+        get_possible_moves(&s->room->maze, s->player_x, s->player_y, moves);
+        strcat(response, moves);
+    } else if (strncmp(cmd, "join ", 5) == 0) {
+        const char *name = cmd + 5;
+        if (name[0] == '\0' || strlen(name) >= ROOM_NAME_LEN ||
+            strchr(name, ' ') != NULL) {
+            strcpy(response, "error: invalid room name");
+            return;
+        }
+        struct room *r = room_find(name);
+        if (r == NULL || r != s->room) {
+            room_leave(s);
+            if (r == NULL && (r = room_create(name)) == NULL) {
+                s->game_started = 0;
+                strcpy(response, "error: could not load the map");
+                return;
+            }
+            room_enter(s, r);
+        }
+        init_board(s);
+        game_log("player #%d joined room %s\n", s->id, name);
+        char *moves = arena_alloc(&command_arena, BUFSZ);
+        get_possible_moves(&r->maze, s->player_x, s->player_y, moves);
+        sprintf(response, "joined room %s as player #%d (%d players)\n%s",
+                name, s->id, r->nmembers, moves);
+    } else if (strcmp(cmd, "whoami") == 0) {
+        sprintf(response, "you are session #%d", s->id);
+        return;
+    } else if (strncmp(cmd, "watch ", 6) == 0) {
+        int id;
+        char extra;
+        struct session *target = NULL;
+        if (sscanf(cmd + 6, "%d%c", &id, &extra) != 1 ||
+            (target = session_find(id)) == NULL || target == s) {
+            strcpy(response, "error: no such session");
+        } else {
+            watch_start(s, target);
+            sprintf(response, "watching session #%d", id);
+        }
+        return;
+    } else if (strcmp(cmd, "unwatch") == 0) {
+        watch_stop(s);
+        strcpy(response, "stopped watching");
+        return;
+    } else if (strncmp(cmd, "encoding ", 9) == 0) {
+        // Codificação dos mapas enviados a esta conexão
+        if (strcmp(cmd + 9, "text") == 0) {
+            s->encoding = MAP_ENCODING_TEXT;
+        } else if (strcmp(cmd + 9, "rle") == 0) {
+            s->encoding = MAP_ENCODING_RLE;
+        } else {
+            strcpy(response, "error: unknown encoding");
+            return;
+        }
+        sprintf(response, "encoding: %s", cmd + 9);
+        return;
+    } else if (strcmp(cmd, "stats") == 0) {
+        format_stats(response, BUFSZ);
+        return;
+    } else if (!s->game_started) {
+        strcpy(response, "error: start the game first!");
+        return;
+    } else if (dir >= 0) {
+        const struct maze *m = &s->room->maze;
+        int next = maze_neighbor(m, cell_index(s->player_x, s->player_y), dir);
+        if (next >= 0 && maze_walkable(m, next)) {
+            s->player_x = cell_x(next);
+            s->player_y = cell_y(next);
+            room_touch(s->room);
+        } else {
+            strcpy(response, "error: you cannot go this way\n");
+        }
+        char *moves = arena_alloc(&command_arena, BUFSZ);
+        get_possible_moves(m, s->player_x, s->player_y, moves);
+        strcat(response, moves);
+    } else if (strcmp(cmd, "map") == 0) {
+        get_map_string(s, 0, s->encoding, response, BUFSZ);
+    } else if (strncmp(cmd, "hint", 4) == 0 &&
+               (cmd[4] == '\0' || cmd[4] == ' ')) {
+        // "hint <n>" limita a dica aos próximos n movimentos
+        int max_moves = 0;
+        char extra;
+        if (cmd[4] == ' ' &&
+            (sscanf(cmd + 5, "%d%c", &max_moves, &extra) != 1 ||
+             max_moves <= 0)) {
+            strcpy(response, "error: invalid hint length");
+        } else {
+            find_path_to_exit(&s->room->maze, s->player_x, s->player_y,
+                              max_moves, response);
+        }
+    } else if (strncmp(cmd, "door ", 5) == 0) {
+        // Comando administrativo: "door <x> <y>" abre ou fecha a porta em
+        // (x, y); "door <x> <y> <segundos>" a troca periodicamente (0 para)
+        struct maze *m = &s->room->maze;
+        const char *args = cmd + 5;
+        int x, y, len = 0, period = -1;
+        char extra;
+        int valid = sscanf(args, "%d %d%n", &x, &y, &len) == 2 &&
+                    (args[len] == '\0' ||
+                     (sscanf(args + len, "%d%c", &period, &extra) == 1 &&
+                      period >= 0));
+        if (s->room->owner != s) {
+            strcpy(response, "error: only the room owner can use doors");
+        } else if (!valid || x < 0 || x >= m->size || y < 0 ||
+                   y >= m->size) {
+            strcpy(response, "error: invalid position");
+        } else if (maze_cell(m, x, y) != DOOR_OPEN &&
+                   maze_cell(m, x, y) != DOOR_CLOSED) {
+            strcpy(response, "error: no door at this position");
+        } else if (period > 0) {
+            room_schedule_door(s->room, cell_index(x, y), period);
+            sprintf(response, "door at (%d, %d) now toggles every %d s", x, y,
+                    period);
+        } else if (period == 0) {
+            room_schedule_door(s->room, cell_index(x, y), 0);
+            sprintf(response, "door at (%d, %d) no longer toggles", x, y);
+        } else if (room_toggle_door(s->room, cell_index(x, y)) != 0) {
+            strcpy(response, "error: a player is standing on this door");
+        } else {
+            sprintf(response, "door at (%d, %d) is now %s", x, y,
+                    maze_cell(m, x, y) == DOOR_OPEN ? "open" : "closed");
+        }
+    } else if (strcmp(cmd, "reset") == 0) {
+        // Salas compartilhadas mantêm o mapa; partidas individuais recomeçam
+        // com o mapa original
+        if (s->room->name[0] != '\0') {
+            init_board(s);
+        } else if (start_private_game(s) != 0) {
+            strcpy(response, "");
+            return;
+        }
+        strcpy(response, "");
+        char *moves = arena_alloc(&command_arena, BUFSZ);
+        get_possible_moves(&s->room->maze, s->player_x, s->player_y, moves);
+        strcat(response, moves);
+        game_log("starting new game\n"); // Adiciona esta linha
+    } else if (strcmp(cmd, "exit") == 0) {
+        timer_cancel(&game_timers, &s->game_timer);
+        room_leave(s);
+        watch_stop(s);
+        s->game_started = 0;
+        s->game_completed = 0;
+        s->watch_dirty = 1;
+        strcpy(response, "");
+        game_log("client disconnected\n");
+        return;
+    } else {
+        strcpy(response, "error: command not found");
+    }
+
+    // Descobre células adjacentes à nova posição do jogador
+    if (dir >= 0) {
+        discover_around(s, s->player_x, s->player_y);
+    }
+
+    // Verifica se o jogador chegou à saída
+    if (maze_cell(&s->room->maze, s->player_x, s->player_y) == EXIT) {
+        s->game_completed = 1;
+        timer_cancel(&game_timers, &s->game_timer);
+        size_t len = buf_append(response, BUFSZ, strlen(response),
+                                "\nYou escaped!\n");
+        get_map_string(s, 1, s->encoding, response + len, BUFSZ - len);
+    }
+}
+
+/**
+ * @brief Transmite as posições dos jogadores de uma sala.
+ *
+ * A mensagem é codificada uma única vez em um frame, e o mesmo frame é
+ * colocado na fila de saída de todos os membros.
+ *
+ * @param r Sala compartilhada.
+ */
+void room_broadcast(struct room *r) {
+    size_t cap = sizeof("[room ] players:") + ROOM_NAME_LEN +
+                 (size_t)r->nmembers * ROOM_ENTRY_MAX;
+    struct frame *f = frame_alloc(cap);
+    int len = snprintf(f->data, cap, "[room %s] players:", r->name);
+    for (struct session *o = r->members; o != NULL; o = o->room_next) {
+        if (o->game_started) {
+            len += snprintf(f->data + len, cap - len, " #%d (%d, %d)", o->id,
+                            o->player_x, o->player_y);
+        }
+    }
+    f->len = len + 1;
+
+    for (struct session *o = r->members; o != NULL; o = o->room_next) {
+        // Quem não lê perde a transmissão; a próxima a substitui
+        if (o->out_bytes >= OUT_QUEUE_MAX_BYTES) {
+            shed_frames++;
+            continue;
+        }
+        session_enqueue(o, f);
+    }
+    frame_release(f);
+    r->dirty = 0;
+}
+
+/**
+ * @brief Executa as tarefas periódicas do servidor.
+ *
+ * Dispara os temporizadores vencidos, envia um frame de posições para cada
+ * sala compartilhada que mudou desde o último tick e, a cada KEYFRAME_TICKS
+ * ticks, keyframes para os espectadores atrasados.
+ */
+void game_tick(long long now_ms) {
+    static int ticks = 0;
+
+    game_now_ms = now_ms;
+    timer_advance(&game_timers, now_ms / TICK_MS);
+
+    for (struct room *r = rooms; r != NULL; r = r->next) {
+        if (r->dirty && r->name[0] != '\0') {
+            room_broadcast(r);
+        }
+        r->dirty = 0;
+    }
+
+    if (++ticks % KEYFRAME_TICKS == 0) {
+        watch_keyframes();
+    }
+
+    if (game_journal) {
+        journal_flush(game_journal);
+    }
+}
+
+/**
+ * @brief Libera todos os recursos de uma sessão.
+ */
+void session_destroy(struct session *s) {
+    timer_cancel(&game_timers, &s->idle_timer);
+    timer_cancel(&game_timers, &s->game_timer);
+    room_leave(s);
+    watch_stop(s);
+
+    // Avisa os espectadores que a sessão terminou
+    while (s->watchers) {
+        struct session *w = s->watchers;
+        char notice[64];
+        snprintf(notice, sizeof(notice), "[watch #%d] session ended", s->id);
+        session_send_text(w, notice);
+        watch_stop(w);
+    }
+    watch_frames_release(s);
+
+    while (s->out_head) {
+        session_dequeue(s);
+    }
+    if (game_journal) {
+        journal_event(game_journal, s->id, OP_DISCONNECT);
+    }
+    if (s->fd >= 0) {
+        close(s->fd);
+    }
+    pool_free(&session_pool, s);
+}
+
+struct session *session_create(int fd) {
+    if (nsessions == MAX_SESSIONS) {
+        return NULL;
+    }
+    struct session *s = pool_alloc(&session_pool);
+    memset(s, 0, sizeof(struct session));
+    s->fd = fd;
+    s->id = next_session_id++;
+    sessions[nsessions++] = s;
+
+    s->tokens = game_rate_limit;
+    s->tokens_ms = game_now_ms;
+
+    s->idle_timer.fn = session_idle_expired;
+    s->idle_timer.arg = s;
+    s->game_timer.fn = game_time_expired;
+    s->game_timer.arg = s;
+    if (game_idle_timeout > 0) {
+        timer_add(&game_timers, &s->idle_timer,
+                  seconds_to_ticks(game_idle_timeout));
+    }
+
+    if (game_journal) {
+        journal_event(game_journal, s->id, OP_CONNECT);
+    }
+    game_log("client connected\n");
+    return s;
+}
+
+void session_command(struct session *s, char *cmd) {
+    // Os temporários do comando anterior já foram copiados para os frames
+    arena_reset(&command_arena);
+    char *response = arena_alloc(&command_arena, BUFSZ);
+    memset(response, 0, BUFSZ);
+
+    if (game_journal) {
+        journal_command(game_journal, s->id, cmd);
+    }
+    if (game_idle_timeout > 0) {
+        timer_add(&game_timers, &s->idle_timer,
+                  seconds_to_ticks(game_idle_timeout));
+    }
+
+    // Processa o comando e coloca a resposta na fila de saída
+    process_command(s, cmd, response);
+    session_send_text(s, response);
+
+    if (strcmp(cmd, "exit") == 0) {
+        s->closing = 1;
+    }
+}
+
+/**
+ * @brief Verifica se a sessão pode executar mais um comando agora.
+ *
+ * Comandos esperam enquanto a fila de saída estiver cheia ou enquanto o
+ * balde de fichas (game_rate_limit fichas por segundo, acumulando no máximo
+ * um segundo) estiver vazio.
+ */
+int session_can_run(struct session *s) {
+    if (s->out_bytes >= OUT_QUEUE_MAX_BYTES) {
+        return 0;
+    }
+    if (game_rate_limit <= 0) {
+        return 1;
+    }
+
+    // Reabastece o balde conforme o tempo passado desde a última verificação
+    s->tokens += (game_now_ms - s->tokens_ms) * game_rate_limit / 1000.0;
+    s->tokens_ms = game_now_ms;
+    if (s->tokens > game_rate_limit) {
+        s->tokens = game_rate_limit;
+    }
+    if (s->tokens < 1) {
+        s->throttled = 1;
+        return 0;
+    }
+    s->throttled = 0;
+    return 1;
+}
+
+int session_readable(const struct session *s) {
+    return !s->closing && !s->throttled && s->inlen < sizeof(s->inbuf) &&
+           s->out_bytes < OUT_QUEUE_MAX_BYTES;
+}
+
+/**
+ * @brief Conta os comandos completos que ficaram esperando em inbuf a partir
+ * de from, cada um uma única vez mesmo que espere por várias rodadas.
+ */
+void session_defer(struct session *s, size_t from) {
+    int pending = 0;
+    for (size_t i = from; i < s->inlen; i++) {
+        pending += s->inbuf[i] == '\0';
+    }
+    if (pending > s->deferred) {
+        deferred_commands += pending - s->deferred;
+        s->deferred = pending;
+    }
+}
+
+void session_process_input(struct session *s) {
+    size_t start = 0;
+    for (size_t i = 0; i < s->inlen && !s->closing; i++) {
+        if (s->inbuf[i] == '\0') {
+            if (!session_can_run(s)) {
+                session_defer(s, i); // Os comandos restantes esperam em inbuf
+                break;
+            }
+            s->tokens--;
+            if (s->deferred > 0) {
+                s->deferred--;
+            }
+            session_command(s, s->inbuf + start);
+            start = i + 1;
+        }
+    }
+
+    // Descarta comandos maiores que o buffer
+    if (start == 0 && s->inlen == sizeof(s->inbuf) &&
+        memchr(s->inbuf, '\0', s->inlen) == NULL) {
+        start = s->inlen;
+    }
+    memmove(s->inbuf, s->inbuf + start, s->inlen - start);
+    s->inlen -= start;
+}
+
+void game_publish(void) {
+    for (int i = 0; i < nsessions; i++) {
+        if (sessions[i]->watch_dirty) {
+            session_publish(sessions[i]);
+        }
+    }
+}
+
+void sessions_sweep(void) {
+    for (int i = 0; i < nsessions;) {
+        struct session *s = sessions[i];
+        if (!s->dead && session_flush(s) != 0) {
+            s->dead = 1;
+        }
+        // Retoma os comandos adiados por sobrecarga
+        if (!s->dead && s->inlen > 0) {
+            session_process_input(s);
+        }
+        if (s->dead || (s->closing && s->out_head == NULL)) {
+            session_destroy(s);
+            sessions[i] = sessions[--nsessions];
+        } else {
+            i++;
+        }
+    }
+}
+
+int game_admit(void) {
+    if (nsessions >= game_max_sessions || nsessions >= MAX_SESSIONS ||
+        game_out_bytes >= GAME_OUT_MAX_BYTES) {
+        shed_connections++;
+        return 0;
+    }
+    return 1;
+}
+
+void game_shutdown(void) {
+    for (int i = 0; i < nsessions; i++) {
+        sessions[i]->dead = 1;
+    }
+    sessions_sweep();
+    next_session_id = 1;
+
+    // Recomeça o relógio: a próxima chamada a game_tick() acerta a roda, e a
+    // próxima sala relê o mapa e volta a agendar a sua releitura
+    timer_cancel(&game_timers, &map_timer);
+    memset(&game_timers, 0, sizeof(game_timers));
+    game_now_ms = 0;
+    map_template_loaded = 0;
+}
@@ -0,0 +1,237 @@
+/**
+ * @file game.h
+ * @brief Arquivo de cabeçalho do núcleo do jogo: sessões, salas e comandos.
+ *
+ * Este arquivo define as estruturas de sessão, sala e frame e as funções que
+ * processam os comandos dos clientes. O núcleo não depende de sockets além
+ * do envio das filas de saída, de modo que pode ser executado em processo
+ * pela ferramenta de replay com sessões sem conexão (fd igual a -1).
+ */
+#pragma once
+
+#include "alloc.h"
+#include "common.h"
+#include "journal.h"
+#include "maze.h"
+#include "timer.h"
+
+#include <stddef.h>
+
+// Tamanho máximo do buffer de mensagens
+#define BUFSZ 1024
+// Número máximo de conexões simultâneas
+#define MAX_SESSIONS 1024
+// Intervalo entre transmissões de posições nas salas, em milissegundos
+#define TICK_MS 100
+// Tamanho máximo do nome de uma sala
+#define ROOM_NAME_LEN 32
+// Frames pendentes a partir dos quais um espectador passa a receber só
+// keyframes
+#define WATCH_QUEUE_MAX 8
+// Intervalo entre keyframes para espectadores lentos, em ticks
+#define KEYFRAME_TICKS 10
+// Número de classes de tamanho dos pools de frames
+#define FRAME_CLASSES 5
+// Maior entrada de um jogador na transmissão da sala: " #<id> (<x>, <y>)"
+#define ROOM_ENTRY_MAX 21
+// Tamanho inicial da arena de temporários de cada comando
+#define COMMAND_ARENA_SIZE (8 * BUFSZ)
+// Bytes pendentes na saída a partir dos quais a sessão deixa de ser lida
+#define OUT_QUEUE_MAX_BYTES (64 * 1024)
+// Bytes pendentes em todas as sessões a partir dos quais novas conexões são
+// recusadas
+#define GAME_OUT_MAX_BYTES (16 * 1024 * 1024)
+
+// Nome padrão do arquivo do mapa
+#define MAP_FILE "input/in.txt"
+
+/**
+ * @brief Mensagem codificada uma única vez e compartilhada entre as filas de
+ * saída de vários destinatários por contagem de referências.
+ */
+struct frame {
+    struct pool *pool; // Pool de origem (NULL se alocado com malloc)
+    int refs;          // Número de referências ainda ativas
+    size_t len;        // Tamanho em bytes, incluindo o '\0' final
+    char data[];       // Conteúdo da mensagem
+};
+
+// Elemento da fila de saída de uma sessão
+struct outbuf {
+    struct frame *frame;
+    struct outbuf *next;
+};
+
+struct room;
+
+/**
+ * @brief Estado de uma conexão de cliente.
+ */
+struct session {
+    int fd;                  // Socket do cliente (-1 no replay)
+    int id;                  // Identificador exibido aos outros jogadores
+    int dead;                // A sessão deve ser removida no fim do laço
+    int closing;             // Fecha a conexão após esvaziar a saída
+    struct room *room;       // Sala em que a sessão joga (ou NULL)
+    struct session *room_prev;
+    struct session *room_next;
+
+    int player_x;
+    int player_y;
+    int game_started;
+    int game_completed;
+    unsigned char discovered[BOARD_CELLS];
+
+    struct session *watching;    // Sessão observada (ou NULL)
+    struct session *watch_prev;  // Lista de espectadores de watching
+    struct session *watch_next;
+    struct session *watchers;    // Espectadores desta sessão
+    // Último estado codificado para espectadores, em cada codificação
+    struct frame *watch_frame[MAP_ENCODING_COUNT];
+    int watch_dirty;             // O estado mudou desde watch_frame
+    int lagging;                 // Espectador lento: recebe só keyframes
+    int encoding;                // Codificação dos mapas enviados
+
+    struct timer idle_timer; // Fecha a conexão ociosa
+    struct timer game_timer; // Tempo limite da partida
+
+    char inbuf[BUFSZ];       // Bytes recebidos ainda não processados
+    size_t inlen;
+    struct outbuf *out_head; // Fila de frames a enviar
+    struct outbuf *out_tail;
+    size_t out_offset;       // Bytes já enviados do primeiro frame
+    int out_count;           // Número de frames na fila
+    size_t out_bytes;        // Bytes dos frames na fila
+
+    double tokens;           // Fichas do limite de comandos por segundo
+    long long tokens_ms;     // Instante da última reposição de fichas
+    int throttled;           // Há comandos esperando por fichas
+    int deferred;            // Comandos em inbuf já contados como adiados
+};
+
+/**
+ * @brief Troca periódica de uma porta de uma sala (door <x> <y> <segundos>).
+ */
+struct door_timer {
+    struct timer timer;
+    struct room *room;
+    int cell;                // Índice da porta
+    int period;              // Intervalo entre trocas, em segundos
+    struct door_timer *next; // Próxima troca agendada na mesma sala
+};
+
+/**
+ * @brief Instância de labirinto compartilhada pelos seus membros.
+ *
+ * Salas sem nome são privadas e pertencem a uma única sessão. Apenas o dono
+ * (o primeiro membro, ou quem o sucede quando ele sai) pode usar o comando
+ * door, para que um jogador qualquer não tranque os demais.
+ */
+struct room {
+    char name[ROOM_NAME_LEN];
+    struct maze maze;
+    struct session *members; // Lista duplamente ligada de membros
+    int nmembers;
+    struct session *owner;   // Membro que controla as portas
+    struct door_timer *door_timers; // Portas com troca periódica
+    int dirty;               // Houve mudança de posições desde o último tick
+    struct room *prev;
+    struct room *next;
+};
+
+// Sessões ativas
+extern struct session *sessions[MAX_SESSIONS];
+extern int nsessions;
+
+// Arquivo do mapa carregado pelas salas
+extern const char *map_file;
+// Se zero, o núcleo não escreve mensagens de acompanhamento em stdout
+extern int game_verbose;
+// Journal de comandos (NULL se desativado)
+extern struct journal *game_journal;
+// Segundos sem comandos até a conexão ser fechada (0 desativa)
+extern int game_idle_timeout;
+// Duração máxima de uma partida em segundos (0 desativa)
+extern int game_time_limit;
+// Intervalo entre as verificações do arquivo do mapa em segundos (0 desativa)
+extern int map_reload_interval;
+// Comandos por segundo aceitos de cada sessão (0 desativa o limite)
+extern int game_rate_limit;
+// Número máximo de sessões admitidas (até MAX_SESSIONS)
+extern int game_max_sessions;
+
+/**
+ * @brief Cria uma sessão para uma conexão.
+ *
+ * @param fd Socket do cliente, ou -1 para sessões sem conexão.
+ * @return Ponteiro para a sessão, ou NULL se o limite foi atingido.
+ */
+struct session *session_create(int fd);
+
+/**
+ * @brief Processa os comandos completos (terminados em '\0') de inbuf.
+ *
+ * Comandos que excedem o limite de comandos por segundo, ou que chegam com a
+ * fila de saída cheia, ficam em inbuf e são retomados em sessions_sweep().
+ */
+void session_process_input(struct session *s);
+
+/**
+ * @brief Verifica se o servidor deve ler mais dados da sessão.
+ *
+ * A leitura pausa enquanto há comandos adiados, o que deixa o excesso no
+ * buffer do sistema e faz o TCP frear o cliente.
+ */
+int session_readable(const struct session *s);
+
+/**
+ * @brief Decide se uma nova conexão pode ser admitida.
+ *
+ * Recusa conexões acima de game_max_sessions ou quando as filas de saída
+ * somam GAME_OUT_MAX_BYTES, contando-as como descartadas.
+ *
+ * @return 1 se a conexão pode ser aceita, 0 caso contrário.
+ */
+int game_admit(void);
+
+/**
+ * @brief Processa um único comando e coloca a resposta na fila de saída.
+ */
+void session_command(struct session *s, char *cmd);
+
+/**
+ * @brief Envia o máximo possível da fila de saída sem bloquear.
+ *
+ * Sessões sem conexão apenas descartam a fila.
+ *
+ * @return 0 em caso de sucesso, -1 se a conexão falhou.
+ */
+int session_flush(struct session *s);
+
+/**
+ * @brief Publica para os espectadores as sessões que mudaram de estado.
+ */
+void game_publish(void);
+
+/**
+ * @brief Envia as filas de saída e remove as sessões encerradas.
+ */
+void sessions_sweep(void);
+
+/**
+ * @brief Executa as tarefas periódicas do jogo (uma vez a cada TICK_MS).
+ *
+ * @param now_ms Instante atual em milissegundos. Deve vir sempre do mesmo
+ *               relógio; a primeira chamada acerta a roda de temporizadores e
+ *               deve acontecer antes de criar sessões.
+ */
+void game_tick(long long now_ms);
+
+/**
+ * @brief Encerra todas as sessões e reinicia a numeração e o relógio dos
+ * temporizadores.
+ *
+ * Depois dela, o núcleo volta ao estado inicial: a próxima chamada a
+ * game_tick() pode usar qualquer instante, inclusive anterior aos já vistos.
+ */
+void game_shutdown(void);
@@ -0,0 +1,242 @@
+/**
+ * @file journal.c
+ * @brief Implementação do registro binário de comandos das sessões.
+ *
+ * Este arquivo implementa o escritor com buffers duplos e thread própria e a
+ * leitura dos registros usada pela ferramenta de replay.
+ */
+#include "journal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Tamanho do cabeçalho de cada registro no arquivo
+#define RECORD_HEADER 14
+
+// Nome de cada operação, na ordem de enum journal_op
+static const char *const op_names[OP_COUNT] = {
+    [OP_START] = "start", [OP_UP] = "up",         [OP_RIGHT] = "right",
+    [OP_DOWN] = "down",   [OP_LEFT] = "left",     [OP_MAP] = "map",
+    [OP_HINT] = "hint",   [OP_DOOR] = "door",     [OP_RESET] = "reset",
+    [OP_EXIT] = "exit",   [OP_JOIN] = "join",     [OP_WHOAMI] = "whoami",
+    [OP_WATCH] = "watch", [OP_UNWATCH] = "unwatch",
+};
+
+/**
+ * @brief Laço da thread escritora: grava cada buffer entregue pela dona.
+ */
+static void *journal_writer(void *arg) {
+    struct journal *j = arg;
+
+    pthread_mutex_lock(&j->lock);
+    while (1) {
+        while (j->pending_len == 0 && !j->stopping) {
+            pthread_cond_wait(&j->cond, &j->lock);
+        }
+        if (j->pending_len == 0) {
+            break; // Encerrando e sem nada pendente
+        }
+        char *buf = j->pending;
+        size_t len = j->pending_len;
+        pthread_mutex_unlock(&j->lock);
+
+        // A gravação acontece fora da trava
+        if (fwrite(buf, 1, len, j->file) != len || fflush(j->file) != 0) {
+            perror("journal");
+        }
+
+        pthread_mutex_lock(&j->lock);
+        j->pending_len = 0;
+        pthread_cond_broadcast(&j->cond);
+    }
+    pthread_mutex_unlock(&j->lock);
+    return NULL;
+}
+
+struct journal *journal_open(const char *path) {
+    FILE *file = fopen(path, "ab");
+    if (file == NULL) {
+        perror("fopen");
+        return NULL;
+    }
+
+    // Arquivos novos começam com a assinatura
+    if (ftell(file) == 0 &&
+        fwrite(JOURNAL_MAGIC, 1, strlen(JOURNAL_MAGIC), file) !=
+            strlen(JOURNAL_MAGIC)) {
+        perror("fwrite");
+        fclose(file);
+        return NULL;
+    }
+
+    struct journal *j = calloc(1, sizeof(struct journal));
+    if (j == NULL) {
+        fclose(file);
+        return NULL;
+    }
+    j->file = file;
+    j->active = malloc(JOURNAL_BUFSZ);
+    j->pending = malloc(JOURNAL_BUFSZ);
+    if (j->active == NULL || j->pending == NULL) {
+        free(j->active);
+        free(j->pending);
+        free(j);
+        fclose(file);
+        return NULL;
+    }
+    pthread_mutex_init(&j->lock, NULL);
+    pthread_cond_init(&j->cond, NULL);
+    if (pthread_create(&j->writer, NULL, journal_writer, j) != 0) {
+        perror("pthread_create");
+        free(j->active);
+        free(j->pending);
+        free(j);
+        fclose(file);
+        return NULL;
+    }
+    return j;
+}
+
+void journal_flush(struct journal *j) {
+    if (j->active_len == 0) {
+        return;
+    }
+    pthread_mutex_lock(&j->lock);
+    if (j->pending_len == 0) {
+        char *tmp = j->pending;
+        j->pending = j->active;
+        j->pending_len = j->active_len;
+        j->active = tmp;
+        j->active_len = 0;
+        pthread_cond_broadcast(&j->cond);
+    }
+    pthread_mutex_unlock(&j->lock);
+}
+
+/**
+ * @brief Anexa um registro ao buffer ativo.
+ */
+static void journal_append(struct journal *j, uint32_t session_id, int opcode,
+                           const char *args, size_t arglen) {
+    size_t need = RECORD_HEADER + arglen;
+    if (j->active_len + need > JOURNAL_BUFSZ) {
+        journal_flush(j);
+        if (j->active_len + need > JOURNAL_BUFSZ) {
+            j->dropped++; // A escritora ainda não terminou o buffer anterior
+            return;
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t timestamp = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    uint8_t op = (uint8_t)opcode;
+    uint8_t len = (uint8_t)arglen;
+
+    char *p = j->active + j->active_len;
+    memcpy(p, &timestamp, 8);
+    memcpy(p + 8, &session_id, 4);
+    memcpy(p + 12, &op, 1);
+    memcpy(p + 13, &len, 1);
+    memcpy(p + RECORD_HEADER, args, arglen);
+    j->active_len += need;
+    j->records++;
+}
+
+void journal_event(struct journal *j, uint32_t session_id, int opcode) {
+    journal_append(j, session_id, opcode, "", 0);
+}
+
+void journal_command(struct journal *j, uint32_t session_id, const char *cmd) {
+    size_t word = strcspn(cmd, " ");
+    for (int op = OP_START; op < OP_OTHER; op++) {
+        if (strlen(op_names[op]) != word ||
+            strncmp(cmd, op_names[op], word) != 0) {
+            continue;
+        }
+        // "hint" não tem argumentos; "hint 3" guarda "3"
+        if (cmd[word] == '\0') {
+            journal_append(j, session_id, op, "", 0);
+            return;
+        }
+        const char *args = cmd + word + 1;
+        if (args[0] != '\0' && strlen(args) <= JOURNAL_MAX_ARGS) {
+            journal_append(j, session_id, op, args, strlen(args));
+            return;
+        }
+        break;
+    }
+
+    // Comandos desconhecidos são guardados por inteiro (truncados)
+    size_t len = strlen(cmd);
+    if (len > JOURNAL_MAX_ARGS) {
+        len = JOURNAL_MAX_ARGS;
+    }
+    journal_append(j, session_id, OP_OTHER, cmd, len);
+}
+
+void journal_close(struct journal *j) {
+    pthread_mutex_lock(&j->lock);
+    while (j->pending_len != 0) {
+        pthread_cond_wait(&j->cond, &j->lock);
+    }
+    pthread_mutex_unlock(&j->lock);
+    journal_flush(j);
+
+    pthread_mutex_lock(&j->lock);
+    j->stopping = 1;
+    pthread_cond_broadcast(&j->cond);
+    pthread_mutex_unlock(&j->lock);
+    pthread_join(j->writer, NULL);
+
+    fprintf(stderr, "journal: %llu records, %llu dropped\n", j->records,
+            j->dropped);
+    fclose(j->file);
+    pthread_mutex_destroy(&j->lock);
+    pthread_cond_destroy(&j->cond);
+    free(j->active);
+    free(j->pending);
+    free(j);
+}
+
+int journal_read_header(FILE *file) {
+    char magic[sizeof(JOURNAL_MAGIC)] = {0};
+    if (fread(magic, 1, strlen(JOURNAL_MAGIC), file) != strlen(JOURNAL_MAGIC) ||
+        strcmp(magic, JOURNAL_MAGIC) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+int journal_read(FILE *file, struct journal_record *rec) {
+    char header[RECORD_HEADER];
+    size_t count = fread(header, 1, RECORD_HEADER, file);
+    if (count == 0) {
+        return 0;
+    }
+    if (count != RECORD_HEADER) {
+        return -1;
+    }
+    memcpy(&rec->timestamp_ns, header, 8);
+    memcpy(&rec->session_id, header + 8, 4);
+    memcpy(&rec->opcode, header + 12, 1);
+    memcpy(&rec->arglen, header + 13, 1);
+    if (rec->opcode >= OP_COUNT ||
+        fread(rec->args, 1, rec->arglen, file) != rec->arglen) {
+        return -1;
+    }
+    rec->args[rec->arglen] = '\0';
+    return 1;
+}
+
+void journal_format_command(const struct journal_record *rec, char *cmd,
+                            size_t size) {
+    if (rec->opcode == OP_OTHER || op_names[rec->opcode] == NULL) {
+        snprintf(cmd, size, "%s", rec->args);
+    } else if (rec->arglen == 0) {
+        snprintf(cmd, size, "%s", op_names[rec->opcode]);
+    } else {
+        snprintf(cmd, size, "%s %s", op_names[rec->opcode], rec->args);
+    }
+}
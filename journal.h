@@ -0,0 +1,136 @@
+/**
+ * @file journal.h
+ * @brief Arquivo de cabeçalho do registro binário de comandos das sessões.
+ *
+ * O registro (journal) guarda, em modo somente-anexação, cada comando
+ * recebido pelo servidor: instante, sessão, código da operação e argumentos.
+ * A escrita em disco é feita por uma thread própria a partir de buffers
+ * duplos, de modo que o laço de eventos nunca espera pelo disco. O mesmo
+ * formato é lido pela ferramenta de replay para reproduzir tráfego real.
+ *
+ * Formato do arquivo: a assinatura JOURNAL_MAGIC seguida de registros com
+ * timestamp (8 bytes, ns), sessão (4 bytes), operação (1 byte), tamanho dos
+ * argumentos (1 byte) e os argumentos, na ordem de bytes do host.
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Assinatura no início do arquivo
+#define JOURNAL_MAGIC "MZJ1"
+// Tamanho de cada um dos dois buffers de escrita
+#define JOURNAL_BUFSZ (64 * 1024)
+// Tamanho máximo dos argumentos de um registro
+#define JOURNAL_MAX_ARGS 255
+
+// Códigos das operações registradas
+enum journal_op {
+    OP_CONNECT,    // Nova conexão (sem argumentos)
+    OP_DISCONNECT, // Fim da conexão (sem argumentos)
+    OP_START,
+    OP_UP,
+    OP_RIGHT,
+    OP_DOWN,
+    OP_LEFT,
+    OP_MAP,
+    OP_HINT,
+    OP_DOOR,
+    OP_RESET,
+    OP_EXIT,
+    OP_JOIN,
+    OP_WHOAMI,
+    OP_WATCH,
+    OP_UNWATCH,
+    OP_OTHER, // Comando desconhecido; os argumentos guardam o texto inteiro
+    OP_COUNT
+};
+
+/**
+ * @brief Registro lido de um arquivo de journal.
+ */
+struct journal_record {
+    uint64_t timestamp_ns;
+    uint32_t session_id;
+    uint8_t opcode;
+    uint8_t arglen;
+    char args[JOURNAL_MAX_ARGS + 1]; // Terminado em '\0'
+};
+
+/**
+ * @brief Escritor bufferizado do journal, pertencente a uma única thread.
+ *
+ * A thread dona preenche o buffer ativo sem bloqueio; quando ele enche (ou
+ * em journal_flush()), os buffers são trocados e a thread escritora grava o
+ * buffer pendente. Se a escritora ainda estiver ocupada, registros que não
+ * cabem são descartados e contados em dropped.
+ */
+struct journal {
+    FILE *file;
+    char *active;       // Buffer preenchido pela thread dona
+    size_t active_len;
+    char *pending;      // Buffer sendo gravado pela thread escritora
+    size_t pending_len; // 0 quando a escritora está livre
+    int stopping;
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned long long records; // Registros aceitos
+    unsigned long long dropped; // Registros descartados
+};
+
+/**
+ * @brief Abre (ou cria) um arquivo de journal para anexação.
+ *
+ * @param path Caminho do arquivo.
+ * @return Escritor do journal, ou NULL em caso de erro.
+ */
+struct journal *journal_open(const char *path);
+
+/**
+ * @brief Registra um comando recebido por uma sessão.
+ */
+void journal_command(struct journal *j, uint32_t session_id, const char *cmd);
+
+/**
+ * @brief Registra um evento sem argumentos (OP_CONNECT, OP_DISCONNECT).
+ */
+void journal_event(struct journal *j, uint32_t session_id, int opcode);
+
+/**
+ * @brief Entrega o buffer ativo à thread escritora, se ela estiver livre.
+ *
+ * Nunca espera pelo disco.
+ */
+void journal_flush(struct journal *j);
+
+/**
+ * @brief Grava os registros restantes, encerra a escritora e fecha o arquivo.
+ */
+void journal_close(struct journal *j);
+
+/**
+ * @brief Verifica a assinatura no início de um arquivo de journal.
+ *
+ * @return 0 se a assinatura é válida, -1 caso contrário.
+ */
+int journal_read_header(FILE *file);
+
+/**
+ * @brief Lê o próximo registro de um arquivo de journal.
+ *
+ * @return 1 se um registro foi lido, 0 no fim do arquivo, -1 em caso de erro.
+ */
+int journal_read(FILE *file, struct journal_record *rec);
+
+/**
+ * @brief Reconstrói o texto do comando de um registro.
+ *
+ * @param rec Registro lido.
+ * @param cmd Buffer onde o comando será armazenado.
+ * @param size Tamanho do buffer.
+ */
+void journal_format_command(const struct journal_record *rec, char *cmd,
+                            size_t size);
@@ -0,0 +1,439 @@
+/**
+ * @file maze.c
+ * @brief Implementação da leitura do labirinto e da busca de caminhos.
+ *
+ * Este arquivo implementa a leitura e validação do arquivo de mapa e o campo
+ * de distâncias até a saída, calculado por busca em largura (BFS) ao carregar
+ * o mapa e usado para gerar dicas de caminho.
+ */
+#include "maze.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int dir_dx[DIR_COUNT] = {0, 1, 0, -1};
+const int dir_dy[DIR_COUNT] = {-1, 0, 1, 0};
+const char *const dir_names[DIR_COUNT] = {"up", "right", "down", "left"};
+
+#ifdef BOARD_MORTON
+const unsigned char morton_spread_table[BOARD_SPAN] = {
+    MORTON_SPREAD4(0),  MORTON_SPREAD4(1),  MORTON_SPREAD4(2),
+    MORTON_SPREAD4(3),  MORTON_SPREAD4(4),  MORTON_SPREAD4(5),
+    MORTON_SPREAD4(6),  MORTON_SPREAD4(7),  MORTON_SPREAD4(8),
+    MORTON_SPREAD4(9),  MORTON_SPREAD4(10), MORTON_SPREAD4(11),
+    MORTON_SPREAD4(12), MORTON_SPREAD4(13), MORTON_SPREAD4(14),
+    MORTON_SPREAD4(15)};
+#endif
+
+/**
+ * @brief Encontra o representante do conjunto de uma célula (union-find).
+ */
+static int uf_find(int *parent, int cell) {
+    while (parent[cell] != cell) {
+        parent[cell] = parent[parent[cell]]; // Compressão por divisão
+        cell = parent[cell];
+    }
+    return cell;
+}
+
+/**
+ * @brief Verifica se uma célula conta para a conectividade estrutural.
+ */
+static int structurally_open(const struct maze *m, int cell) {
+    int value = m->cells[cell];
+    return value == PATH || value == EXIT || value == ENTRANCE ||
+           value == DOOR_OPEN || value == DOOR_CLOSED;
+}
+
+void maze_build_components(struct maze *m) {
+    int parent[BOARD_CELLS];
+
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        parent[i] = i;
+    }
+
+    // Basta unir cada célula aos vizinhos da direita e de baixo
+    for (int y = 0; y < m->size; y++) {
+        for (int x = 0; x < m->size; x++) {
+            int cell = cell_index(x, y);
+            if (!structurally_open(m, cell)) {
+                continue;
+            }
+            for (int dir = DIR_RIGHT; dir <= DIR_DOWN; dir++) {
+                int next = maze_neighbor(m, cell, dir);
+                if (next >= 0 && structurally_open(m, next)) {
+                    parent[uf_find(parent, next)] = uf_find(parent, cell);
+                }
+            }
+        }
+    }
+
+    // Converte os representantes em rótulos compactos a partir de 1
+    unsigned short label[BOARD_CELLS] = {0};
+    unsigned short next_label = 0;
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        m->comp[i] = 0;
+    }
+    for (int y = 0; y < m->size; y++) {
+        for (int x = 0; x < m->size; x++) {
+            int cell = cell_index(x, y);
+            if (!structurally_open(m, cell)) {
+                continue;
+            }
+            int root = uf_find(parent, cell);
+            if (label[root] == 0) {
+                label[root] = ++next_label;
+            }
+            m->comp[cell] = label[root];
+        }
+    }
+}
+
+void maze_build_distances(struct maze *m) {
+    int queue[BOARD_CELLS];
+    int head = 0, tail = 0;
+
+    for (int i = 0; i < BOARD_CELLS; i++) {
+        m->dist[i] = DIST_INF;
+    }
+
+    m->dist[m->exit_cell] = 0;
+    queue[tail++] = m->exit_cell;
+
+    while (head < tail) {
+        int current = queue[head++];
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            int next = maze_neighbor(m, current, dir);
+            if (next >= 0 && m->dist[next] == DIST_INF &&
+                maze_walkable(m, next)) {
+                m->dist[next] = m->dist[current] + 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Menor distância entre os vizinhos livres de uma célula.
+ */
+static unsigned min_neighbor_dist(const struct maze *m, int cell) {
+    unsigned best = DIST_INF;
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        int n = maze_neighbor(m, cell, dir);
+        if (n >= 0 && maze_walkable(m, n) && m->dist[n] < best) {
+            best = m->dist[n];
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Propaga reduções de distância a partir de um conjunto de sementes.
+ *
+ * As sementes já receberam distância e estão em ordem crescente dela. Elas
+ * são intercaladas com uma fila FIFO das células alcançadas, de modo que as
+ * células saem sempre em ordem crescente de distância e cada uma entra na
+ * fila no máximo uma vez.
+ *
+ * @param m Labirinto.
+ * @param seeds Índices das sementes, em ordem crescente de distância.
+ * @param seed_dist Distância atribuída a cada semente.
+ * @param nseeds Número de sementes.
+ */
+static void propagate_decrease(struct maze *m, const int *seeds,
+                               const unsigned short *seed_dist, int nseeds) {
+    int queue[BOARD_CELLS];
+    int head = 0, tail = 0, s = 0;
+
+    while (s < nseeds || head < tail) {
+        int current;
+        if (head == tail ||
+            (s < nseeds && seed_dist[s] <= m->dist[queue[head]])) {
+            current = seeds[s];
+            if (m->dist[current] < seed_dist[s++]) {
+                continue; // Já alcançada com distância menor
+            }
+        } else {
+            current = queue[head++];
+        }
+
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            int next = maze_neighbor(m, current, dir);
+            if (next >= 0 && maze_walkable(m, next) &&
+                m->dist[next] > m->dist[current] + 1) {
+                m->dist[next] = m->dist[current] + 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Corrige o campo de distâncias após uma porta abrir.
+ */
+static void repair_open(struct maze *m, int cell) {
+    unsigned best = min_neighbor_dist(m, cell);
+    if (best == DIST_INF) {
+        return; // A porta continua isolada da saída
+    }
+    m->dist[cell] = best + 1;
+    unsigned short seed_dist = m->dist[cell];
+    propagate_decrease(m, &cell, &seed_dist, 1);
+}
+
+/**
+ * @brief Corrige o campo de distâncias após uma porta fechar.
+ */
+static void repair_close(struct maze *m, int cell) {
+    int affected[BOARD_CELLS];
+    unsigned short old[BOARD_CELLS];
+    int count = 0;
+
+    if (m->dist[cell] == DIST_INF) {
+        return; // A porta não fazia parte de nenhum caminho até a saída
+    }
+
+    // Fase 1: invalida as células que dependiam da porta
+    old[count] = m->dist[cell];
+    affected[count++] = cell;
+    m->dist[cell] = DIST_INF;
+
+    for (int i = 0; i < count; i++) {
+        for (int dir = 0; dir < DIR_COUNT; dir++) {
+            int n = maze_neighbor(m, affected[i], dir);
+            if (n < 0 || !maze_walkable(m, n) || m->dist[n] != old[i] + 1) {
+                continue;
+            }
+            // Mantém a distância se outro vizinho ainda a sustenta
+            if (min_neighbor_dist(m, n) == old[i]) {
+                continue;
+            }
+            old[count] = m->dist[n];
+            affected[count++] = n;
+            m->dist[n] = DIST_INF;
+        }
+    }
+
+    // Fase 2: as células invalidadas vizinhas da região ainda válida viram
+    // sementes, ordenadas por distância, e a propagação refaz o restante.
+    int seeds[BOARD_CELLS];
+    unsigned short seed_dist[BOARD_CELLS];
+    int nseeds = 0;
+    for (int i = 1; i < count; i++) {
+        unsigned best = min_neighbor_dist(m, affected[i]);
+        if (best == DIST_INF) {
+            continue;
+        }
+        int j = nseeds++;
+        while (j > 0 && seed_dist[j - 1] > best + 1) {
+            seeds[j] = seeds[j - 1];
+            seed_dist[j] = seed_dist[j - 1];
+            j--;
+        }
+        seeds[j] = affected[i];
+        seed_dist[j] = best + 1;
+    }
+    for (int i = 0; i < nseeds; i++) {
+        m->dist[seeds[i]] = seed_dist[i];
+    }
+    propagate_decrease(m, seeds, seed_dist, nseeds);
+}
+
+int maze_toggle_door(struct maze *m, int cell) {
+    if (m->cells[cell] == DOOR_CLOSED) {
+        m->cells[cell] = DOOR_OPEN;
+        repair_open(m, cell);
+    } else if (m->cells[cell] == DOOR_OPEN) {
+        m->cells[cell] = DOOR_CLOSED;
+        repair_close(m, cell);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Escolhe o próximo passo em direção à saída.
+ *
+ * @param m Labirinto.
+ * @param cell Índice da célula atual.
+ * @param next Onde o índice do vizinho escolhido será armazenado.
+ * @return Direção escolhida, ou -1 se nenhum vizinho alcança a saída.
+ */
+static int next_step(const struct maze *m, int cell, int *next) {
+    int best_dir = -1;
+    unsigned best = DIST_INF;
+    for (int dir = 0; dir < DIR_COUNT; dir++) {
+        int n = maze_neighbor(m, cell, dir);
+        if (n >= 0 && maze_walkable(m, n) && m->dist[n] < best) {
+            best = m->dist[n];
+            best_dir = dir;
+            *next = n;
+        }
+    }
+    return best_dir;
+}
+
+char *find_path_to_exit(const struct maze *m, int start_x, int start_y,
+                        int max_moves, char *hint) {
+    int cell = cell_index(start_x, start_y);
+
+    if (!maze_connected_to_exit(m, cell)) {
+        strcpy(hint, "No path to exit found!");
+        return hint;
+    }
+
+    strcpy(hint, "Hint: ");
+    char *p = hint + strlen(hint);
+
+    for (int moves = 0; cell != m->exit_cell; moves++) {
+        if (max_moves > 0 && moves == max_moves) {
+            break;
+        }
+        int dir = next_step(m, cell, &cell);
+        if (dir < 0) {
+            strcpy(hint, "No path to exit found!");
+            return hint;
+        }
+        if (moves > 0) {
+            *p++ = ',';
+            *p++ = ' ';
+        }
+        strcpy(p, dir_names[dir]);
+        p += strlen(p);
+    }
+    return hint;
+}
+
+int maze_path_length(const struct maze *m, int start_x, int start_y) {
+    int cell = cell_index(start_x, start_y);
+    int moves = 0;
+    while (cell != m->exit_cell) {
+        if (next_step(m, cell, &cell) < 0) {
+            return -1;
+        }
+        moves++;
+    }
+    return moves;
+}
+
+int maze_load(struct maze *m, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("fopen");
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+
+    char line[256];
+    int rows = 0;
+    int cols = 0;
+
+    // Lê a primeira linha para determinar o número de colunas
+    if (fgets(line, sizeof(line), file)) {
+        char *saveptr;
+        char *token = strtok_r(line, " \t\n", &saveptr);
+        while (token != NULL) {
+            cols++;
+            token = strtok_r(NULL, " \t\n", &saveptr);
+        }
+        rows = 1;
+    }
+
+    // Conta o número de linhas
+    while (fgets(line, sizeof(line), file)) {
+        if (strlen(line) > 1) { // Ignora linhas vazias
+            rows++;
+        }
+    }
+
+    // Verifica se o tabuleiro é quadrado e tem tamanho válido
+    if (rows != cols || rows < MIN_BOARD_SIZE || rows > MAX_BOARD_SIZE) {
+        fprintf(stderr,
+                "Error: Invalid map format in %s. Board must be square between "
+                "[%d x %d] and [%d x %d].\n",
+                path, MIN_BOARD_SIZE, MIN_BOARD_SIZE, MAX_BOARD_SIZE,
+                MAX_BOARD_SIZE);
+        fclose(file);
+        return -1;
+    }
+
+    m->size = rows;
+
+    // Volta ao início do arquivo para ler o tabuleiro
+    rewind(file);
+
+    int entrance_found = 0;
+    int exit_found = 0;
+
+    // Lê o mapa do arquivo
+    for (int i = 0; i < m->size; i++) {
+        for (int j = 0; j < m->size; j++) {
+            int value;
+            if (fscanf(file, "%d", &value) != 1) {
+                fprintf(stderr, "Error: Invalid map format in %s.\n", path);
+                fclose(file);
+                return -1;
+            }
+
+            // Verifica se o valor é válido
+            if (value < 0 || value > DOOR_OPEN) {
+                fprintf(stderr,
+                        "Error: Invalid cell value '%d' in map file %s.\n",
+                        value, path);
+                fclose(file);
+                return -1;
+            }
+
+            m->cells[cell_index(j, i)] = (unsigned char)value;
+
+            // Conta entradas e saídas
+            if (value == ENTRANCE) {
+                if (entrance_found > 0) {
+                    fprintf(stderr,
+                            "Error: Multiple entrances found in map file %s.\n",
+                            path);
+                    fclose(file);
+                    return -1;
+                }
+                entrance_found++;
+                m->entrance_x = j;
+                m->entrance_y = i;
+            } else if (value == EXIT) {
+                if (exit_found > 0) {
+                    fprintf(stderr,
+                            "Error: Multiple exits found in map file %s.\n",
+                            path);
+                    fclose(file);
+                    return -1;
+                }
+                exit_found++;
+                m->exit_cell = cell_index(j, i);
+            }
+        }
+    }
+
+    // Verifica se há exatamente uma entrada e uma saída
+    if (entrance_found != 1 || exit_found != 1) {
+        fprintf(stderr,
+                "Error: Map must have exactly one entrance and one exit.\n");
+        fclose(file);
+        return -1;
+    }
+
+    fclose(file);
+
+    // Rejeita mapas cuja saída não pode ser alcançada a partir da entrada
+    maze_build_components(m);
+    if (!maze_connected_to_exit(m, cell_index(m->entrance_x, m->entrance_y))) {
+        fprintf(stderr, "Error: Exit is unreachable from the entrance in map "
+                        "file %s.\n",
+                path);
+        return -1;
+    }
+
+    maze_build_distances(m);
+    return 0;
+}
@@ -0,0 +1,273 @@
+/**
+ * @file maze.h
+ * @brief Arquivo de cabeçalho com a representação do tabuleiro do labirinto.
+ *
+ * Este arquivo define a estrutura do labirinto, as constantes dos elementos
+ * do mapa e as funções auxiliares de indexação das células. As células são
+ * armazenadas com 1 byte cada, em ordem por linhas (padrão) ou em ordem Z
+ * (Morton) quando compilado com -DBOARD_MORTON, o que mantém vizinhos
+ * verticais próximos na memória. Todo acesso ao tabuleiro deve passar pelas
+ * funções cell_index() e maze_neighbor() para que o layout seja respeitado.
+ */
+#pragma once
+
+// Tamanho máximo do tabuleiro
+#define MAX_BOARD_SIZE 10
+// Tamanho mínimo do tabuleiro
+#define MIN_BOARD_SIZE 5
+
+// Constantes para os elementos do mapa
+#define WALL 0         // Parede
+#define PATH 1         // Caminho livre
+#define ENTRANCE 2     // Entrada do labirinto
+#define EXIT 3         // Saída do labirinto
+#define UNDISCOVERED 4 // Célula não descoberta
+#define PLAYER 5       // Posição do jogador
+#define DOOR_CLOSED 6  // Porta fechada (bloqueia a passagem)
+#define DOOR_OPEN 7    // Porta aberta (livre para passagem)
+
+#ifdef BOARD_MORTON
+// Lado do quadrado endereçável em ordem Z (potência de 2 >= MAX_BOARD_SIZE)
+#define BOARD_SPAN 16
+_Static_assert(BOARD_SPAN >= MAX_BOARD_SIZE &&
+                   (BOARD_SPAN & (BOARD_SPAN - 1)) == 0,
+               "BOARD_SPAN must be a power of two >= MAX_BOARD_SIZE");
+#else
+#define BOARD_SPAN MAX_BOARD_SIZE
+#endif
+
+// Número de posições nos vetores indexados por cell_index()
+#define BOARD_CELLS (BOARD_SPAN * BOARD_SPAN)
+
+// Distância das células que não alcançam a saída
+#define DIST_INF 0xffff
+
+// Direções de movimento, em sentido horário começando por cima
+enum direction { DIR_UP, DIR_RIGHT, DIR_DOWN, DIR_LEFT, DIR_COUNT };
+
+// Deslocamentos e nomes de cada direção
+extern const int dir_dx[DIR_COUNT];
+extern const int dir_dy[DIR_COUNT];
+extern const char *const dir_names[DIR_COUNT];
+
+/**
+ * @brief Estrutura que representa um labirinto carregado.
+ */
+struct maze {
+    int size;                         // Lado do tabuleiro (quadrado)
+    int entrance_x;                   // Coluna da entrada
+    int entrance_y;                   // Linha da entrada
+    int exit_cell;                    // Índice da saída
+    unsigned char cells[BOARD_CELLS]; // Células, indexadas por cell_index()
+    unsigned short dist[BOARD_CELLS]; // Passos até a saída (DIST_INF se não há)
+    unsigned short comp[BOARD_CELLS]; // Componente conexo (0 para paredes)
+};
+
+#ifdef BOARD_MORTON
+/**
+ * @brief Intercala os bits de v com zeros (0b1011 -> 0b01000101).
+ */
+static inline unsigned morton_spread(unsigned v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+/**
+ * @brief Operação inversa de morton_spread().
+ */
+static inline unsigned morton_compact(unsigned v) {
+    v &= 0x55555555;
+    v = (v | (v >> 1)) & 0x33333333;
+    v = (v | (v >> 2)) & 0x0f0f0f0f;
+    v = (v | (v >> 4)) & 0x00ff00ff;
+    v = (v | (v >> 8)) & 0x0000ffff;
+    return v;
+}
+
+static inline int cell_index(int x, int y) {
+    return (int)(morton_spread(x) | (morton_spread(y) << 1));
+}
+
+static inline int cell_x(int idx) { return (int)morton_compact(idx); }
+
+static inline int cell_y(int idx) { return (int)morton_compact(idx >> 1); }
+
+// Intercala os 4 bits de v com zeros, em expressão constante
+#define MORTON_SPREAD4(v)                                                      \
+    (((v)&1) | ((v)&2) << 1 | ((v)&4) << 2 | ((v)&8) << 3)
+_Static_assert(BOARD_SPAN <= 16, "MORTON_SPREAD4 covers 4 bits per axis");
+// Bits do índice que codificam x e y
+#define MORTON_X_MASK MORTON_SPREAD4(BOARD_SPAN - 1)
+#define MORTON_Y_MASK (MORTON_X_MASK << 1)
+
+// morton_spread() de cada coluna, usado nos limites de maze_neighbor()
+extern const unsigned char morton_spread_table[BOARD_SPAN];
+#else
+/**
+ * @brief Converte coordenadas (x, y) no índice da célula.
+ */
+static inline int cell_index(int x, int y) { return y * BOARD_SPAN + x; }
+
+/**
+ * @brief Obtém a coluna de um índice de célula.
+ */
+static inline int cell_x(int idx) { return idx % BOARD_SPAN; }
+
+/**
+ * @brief Obtém a linha de um índice de célula.
+ */
+static inline int cell_y(int idx) { return idx / BOARD_SPAN; }
+#endif
+
+/**
+ * @brief Obtém o valor da célula nas coordenadas (x, y).
+ */
+static inline int maze_cell(const struct maze *m, int x, int y) {
+    return m->cells[cell_index(x, y)];
+}
+
+/**
+ * @brief Verifica se o jogador pode ocupar a célula de índice idx.
+ */
+static inline int maze_walkable(const struct maze *m, int idx) {
+    return m->cells[idx] == PATH || m->cells[idx] == EXIT ||
+           m->cells[idx] == DOOR_OPEN;
+}
+
+/**
+ * @brief Obtém o índice do vizinho de uma célula em uma direção.
+ *
+ * @param m Labirinto.
+ * @param idx Índice da célula de origem.
+ * @param dir Direção (enum direction).
+ * @return Índice do vizinho, ou -1 se ele estiver fora do tabuleiro.
+ */
+static inline int maze_neighbor(const struct maze *m, int idx, int dir) {
+#ifdef BOARD_MORTON
+    // Anda direto no índice intercalado: somar ou subtrair 1 de um eixo
+    // propaga o transporte apenas pelos bits desse eixo. Como a ordem de cada
+    // eixo é preservada, os limites são comparados sem decodificar o índice.
+    unsigned x = idx & MORTON_X_MASK;
+    unsigned y = idx & MORTON_Y_MASK;
+    unsigned last = morton_spread_table[m->size - 1];
+    switch (dir) {
+    case DIR_UP:
+        return y == 0 ? -1 : (int)(x | ((y - 1) & MORTON_Y_MASK));
+    case DIR_RIGHT:
+        if (x == last) {
+            return -1;
+        }
+        return (int)((((x | MORTON_Y_MASK) + 1) & MORTON_X_MASK) | y);
+    case DIR_DOWN:
+        if (y == last << 1) {
+            return -1;
+        }
+        return (int)(x | (((y | MORTON_X_MASK) + 1) & MORTON_Y_MASK));
+    default:
+        return x == 0 ? -1 : (int)(((x - 1) & MORTON_X_MASK) | y);
+    }
+#else
+    int x = cell_x(idx) + dir_dx[dir];
+    int y = cell_y(idx) + dir_dy[dir];
+    if (x < 0 || x >= m->size || y < 0 || y >= m->size) {
+        return -1;
+    }
+    return cell_index(x, y);
+#endif
+}
+
+/**
+ * @brief Lê um labirinto a partir de um arquivo texto.
+ *
+ * Determina automaticamente o tamanho do tabuleiro e verifica se o formato é
+ * válido (quadrado, valores conhecidos, exatamente uma entrada e uma saída,
+ * e a saída alcançável a partir da entrada com todas as portas abertas).
+ *
+ * @param m Labirinto a ser preenchido.
+ * @param path Caminho do arquivo do mapa.
+ * @return 0 em caso de sucesso, -1 em caso de erro.
+ */
+int maze_load(struct maze *m, const char *path);
+
+/**
+ * @brief Rotula os componentes conexos do labirinto.
+ *
+ * Usa union-find sobre as células transitáveis, contando portas (abertas ou
+ * fechadas) e a entrada como transitáveis. Duas células com rótulos
+ * diferentes em m->comp nunca se alcançam, qualquer que seja o estado das
+ * portas. É chamada por maze_load().
+ *
+ * @param m Labirinto.
+ */
+void maze_build_components(struct maze *m);
+
+/**
+ * @brief Verifica em O(1) se uma célula pode, em algum momento, chegar à saída.
+ *
+ * @param m Labirinto.
+ * @param cell Índice da célula.
+ * @return 1 se a célula está no componente da saída, 0 caso contrário.
+ */
+static inline int maze_connected_to_exit(const struct maze *m, int cell) {
+    return m->comp[cell] != 0 && m->comp[cell] == m->comp[m->exit_cell];
+}
+
+/**
+ * @brief Calcula o campo de distâncias até a saída.
+ *
+ * Executa uma única busca em largura (BFS) a partir da saída e grava em
+ * m->dist o número de passos de cada célula livre até ela. É chamada por
+ * maze_load(), de modo que as dicas não precisam de nenhuma busca.
+ *
+ * @param m Labirinto.
+ */
+void maze_build_distances(struct maze *m);
+
+/**
+ * @brief Abre ou fecha uma porta e corrige o campo de distâncias.
+ *
+ * Em vez de recalcular o campo inteiro, apenas a região afetada é refeita.
+ * Ao abrir, a nova distância da porta é propagada enquanto ela encurtar
+ * caminhos. Ao fechar, as células cujo único apoio (vizinho a um passo mais
+ * perto da saída) passava pela porta são invalidadas e recebem novas
+ * distâncias a partir da fronteira ainda válida.
+ *
+ * @param m Labirinto.
+ * @param cell Índice da célula da porta.
+ * @return 0 em caso de sucesso, -1 se a célula não for uma porta.
+ */
+int maze_toggle_door(struct maze *m, int cell);
+
+/**
+ * @brief Escreve o caminho mais curto até a saída a partir de uma posição.
+ *
+ * O caminho é obtido descendo o campo de distâncias, escolhendo em cada passo
+ * a primeira direção (em sentido horário começando por cima) que se aproxima
+ * da saída. O custo é proporcional ao número de movimentos escritos.
+ *
+ * @param m Labirinto.
+ * @param start_x Coordenada x da posição inicial.
+ * @param start_y Coordenada y da posição inicial.
+ * @param max_moves Número máximo de movimentos (0 para o caminho inteiro).
+ * @param hint String onde o caminho encontrado será armazenado.
+ * @return Ponteiro para a string hint.
+ */
+char *find_path_to_exit(const struct maze *m, int start_x, int start_y,
+                        int max_moves, char *hint);
+
+/**
+ * @brief Conta os movimentos do caminho mais curto até a saída.
+ *
+ * Segue o mesmo caminho que find_path_to_exit() escreveria.
+ *
+ * @param m Labirinto.
+ * @param start_x Coordenada x da posição inicial.
+ * @param start_y Coordenada y da posição inicial.
+ * @return Número de movimentos, ou -1 se a saída não é alcançável com as
+ *         portas no estado atual.
+ */
+int maze_path_length(const struct maze *m, int start_x, int start_y);
@@ -0,0 +1,208 @@
+/**
+ * @file replay.c
+ * @brief Ferramenta de replay do journal de comandos.
+ *
+ * Lê um journal gravado pelo servidor (opção -l) e reproduz os comandos no
+ * núcleo do jogo, no mesmo processo e na velocidade máxima, sem rede. As
+ * sessões são criadas sem conexão e as respostas são descartadas; os ticks
+ * acontecem conforme os timestamps gravados. Ao final, informa quantos
+ * comandos por segundo o núcleo processou.
+ */
+#include "common.h"
+#include "game.h"
+#include "journal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Exibe a mensagem de uso do programa e encerra a execução.
+ *
+ * @param argc Número de argumentos da linha de comando.
+ * @param argv Vetor de strings contendo os argumentos da linha de comando.
+ */
+void usage(int argc, char **argv) {
+    printf("usage: %s <journal file> [-i <map file>] [-n <passes>]\n",
+           argv[0]);
+    printf("example: %s session.log -i input/in.txt -n 10\n", argv[0]);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Lê todos os registros de um journal para a memória.
+ *
+ * @param path Caminho do arquivo.
+ * @param count Onde o número de registros será armazenado.
+ * @return Vetor de registros (liberar com free), ou NULL em caso de erro.
+ */
+struct journal_record *load_journal(const char *path, size_t *count) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror("fopen");
+        return NULL;
+    }
+    if (journal_read_header(file) != 0) {
+        fprintf(stderr, "Error: %s is not a journal file.\n", path);
+        fclose(file);
+        return NULL;
+    }
+
+    size_t cap = 1024;
+    size_t n = 0;
+    struct journal_record *records = malloc(cap * sizeof(*records));
+    if (records == NULL) {
+        logexit("malloc");
+    }
+
+    int status;
+    while ((status = journal_read(file, &records[n])) == 1) {
+        if (++n == cap) {
+            cap *= 2;
+            records = realloc(records, cap * sizeof(*records));
+            if (records == NULL) {
+                logexit("realloc");
+            }
+        }
+    }
+    if (status < 0) {
+        fprintf(stderr, "Warning: truncated record at the end of %s.\n",
+                path);
+    }
+
+    fclose(file);
+    *count = n;
+    return records;
+}
+
+/**
+ * @brief Reproduz uma vez os registros no núcleo do jogo.
+ *
+ * @param records Registros do journal.
+ * @param count Número de registros.
+ * @param by_id Tabela de sessões indexada pelo identificador gravado.
+ * @param max_id Maior identificador de sessão gravado.
+ * @return Número de comandos processados.
+ */
+unsigned long long replay_pass(const struct journal_record *records,
+                               size_t count, struct session **by_id,
+                               uint32_t max_id) {
+    unsigned long long commands = 0;
+    uint64_t next_tick = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct journal_record *rec = &records[i];
+        uint32_t id = rec->session_id;
+
+        // Uma nova execução do servidor recomeça a numeração e o relógio,
+        // mesmo que todas as sessões da anterior já tenham sido fechadas
+        if (rec->opcode == OP_CONNECT && id == 1) {
+            game_shutdown();
+            memset(by_id, 0, sizeof(*by_id) * (max_id + 1));
+            next_tick = 0;
+        }
+
+        // Os ticks seguem o relógio gravado
+        if (rec->timestamp_ns >= next_tick) {
+            game_tick(rec->timestamp_ns / 1000000);
+            next_tick = rec->timestamp_ns + (uint64_t)TICK_MS * 1000000;
+        }
+
+        if (rec->opcode == OP_CONNECT) {
+            by_id[id] = session_create(-1);
+        } else if (rec->opcode == OP_DISCONNECT) {
+            if (by_id[id]) {
+                by_id[id]->dead = 1;
+                by_id[id] = NULL;
+            }
+        } else if (by_id[id]) {
+            char cmd[BUFSZ];
+            journal_format_command(rec, cmd, sizeof(cmd));
+            session_command(by_id[id], cmd);
+            if (by_id[id]->closing) {
+                by_id[id] = NULL; // Será removida em sessions_sweep()
+            }
+            commands++;
+        }
+
+        game_publish();
+        sessions_sweep();
+    }
+
+    game_shutdown();
+    return commands;
+}
+
+/**
+ * @brief Função principal da ferramenta de replay.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage(argc, argv);
+    }
+
+    const char *journal_path = argv[1];
+    int passes = 1;
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "i:n:")) != -1) {
+        switch (opt) {
+        case 'i':
+            map_file = optarg;
+            break;
+        case 'n':
+            passes = atoi(optarg);
+            if (passes <= 0) {
+                usage(argc, argv);
+            }
+            break;
+        default:
+            usage(argc, argv);
+        }
+    }
+
+    size_t count;
+    struct journal_record *records = load_journal(journal_path, &count);
+    if (records == NULL) {
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t max_id = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].session_id > max_id) {
+            max_id = records[i].session_id;
+        }
+    }
+    struct session **by_id = calloc(max_id + 1, sizeof(*by_id));
+    if (by_id == NULL) {
+        logexit("calloc");
+    }
+
+    game_verbose = 0;
+    // Desconexões por inatividade já estão gravadas no journal
+    game_idle_timeout = 0;
+    game_time_limit = 0;
+    map_reload_interval = 0;
+
+    struct timespec begin, end;
+    unsigned long long commands = 0;
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (int p = 0; p < passes; p++) {
+        memset(by_id, 0, sizeof(*by_id) * (max_id + 1));
+        commands += replay_pass(records, count, by_id, max_id);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed =
+        (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+    printf("replayed %llu commands (%zu records, %d passes) in %.3f s: "
+           "%.0f commands/s\n",
+           commands, count, passes, elapsed,
+           elapsed > 0 ? commands / elapsed : 0.0);
+
+    free(by_id);
+    free(records);
+    return 0;
+}
@@ -0,0 +1,361 @@
+/**
+ * @file solver.c
+ * @brief Resolvedor em lote de um diretório de mapas.
+ *
+ * Carrega cada mapa de um diretório com o mesmo leitor e validador do
+ * servidor (maze_load()) e o resolve com o mesmo campo de distâncias usado
+ * pelo comando hint, distribuindo os mapas entre threads com roubo de
+ * tarefas: cada thread tem a sua própria fila e, quando ela esvazia, rouba
+ * mapas do início da fila de outra thread. O resultado é um CSV em stdout
+ * com uma linha por mapa, na ordem alfabética dos arquivos.
+ */
+#include "common.h"
+#include "maze.h"
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+/**
+ * @brief Resultado da resolução de um mapa.
+ */
+struct result {
+    int valid;       // O mapa passou na validação de maze_load()
+    int path_length; // Movimentos da entrada até a saída (-1 se não há)
+    int reachable;   // Células alcançáveis a partir da entrada
+    double solve_us; // Tempo de leitura e resolução, em microssegundos
+};
+
+/**
+ * @brief Fila de mapas de uma thread.
+ *
+ * A dona retira do fim e as outras threads roubam do início.
+ */
+struct deque {
+    pthread_mutex_t lock;
+    int *tasks; // Índices dos mapas
+    int head;   // Próxima tarefa a ser roubada
+    int tail;   // Uma posição após a última tarefa
+};
+
+/**
+ * @brief Estado de uma thread de trabalho.
+ */
+struct worker {
+    pthread_t thread;
+    int id;
+    struct deque queue;
+    int solved; // Mapas resolvidos por esta thread
+    int stolen; // Mapas roubados de outras threads
+};
+
+// Mapas a resolver e seus resultados
+char **map_paths;
+struct result *results;
+
+// Threads de trabalho
+struct worker *workers;
+int nworkers;
+
+/**
+ * @brief Exibe a mensagem de uso do programa e encerra a execução.
+ *
+ * @param argc Número de argumentos da linha de comando.
+ * @param argv Vetor de strings contendo os argumentos da linha de comando.
+ */
+void usage(int argc, char **argv) {
+    printf("usage: %s <map directory> [-j <threads>]\n", argv[0]);
+    printf("example: %s maps/ -j 8 > results.csv\n", argv[0]);
+    exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Obtém o instante atual em segundos (relógio monotônico).
+ */
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Compara dois caminhos para qsort().
+ */
+int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief Lista os arquivos regulares de um diretório em ordem alfabética.
+ *
+ * @param dir Caminho do diretório.
+ * @param count Onde o número de arquivos será armazenado.
+ * @return Vetor de caminhos (liberar cada um e o vetor com free), ou NULL em
+ *         caso de erro.
+ */
+char **list_maps(const char *dir, int *count) {
+    DIR *d = opendir(dir);
+    if (d == NULL) {
+        perror("opendir");
+        return NULL;
+    }
+
+    int cap = 64;
+    int n = 0;
+    char **paths = malloc(cap * sizeof(char *));
+    if (paths == NULL) {
+        logexit("malloc");
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        size_t len = strlen(dir) + strlen(entry->d_name) + 2;
+        char *path = malloc(len);
+        if (path == NULL) {
+            logexit("malloc");
+        }
+        snprintf(path, len, "%s/%s", dir, entry->d_name);
+
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            free(path);
+            continue;
+        }
+        if (n == cap) {
+            cap *= 2;
+            paths = realloc(paths, cap * sizeof(char *));
+            if (paths == NULL) {
+                logexit("realloc");
+            }
+        }
+        paths[n++] = path;
+    }
+    closedir(d);
+
+    qsort(paths, n, sizeof(char *), compare_paths);
+    *count = n;
+    return paths;
+}
+
+/**
+ * @brief Conta as células do componente da entrada, incluindo a entrada.
+ *
+ * Portas contam como transitáveis, como na validação de maze_load().
+ */
+int count_reachable(const struct maze *m) {
+    int comp = m->comp[cell_index(m->entrance_x, m->entrance_y)];
+    int count = 0;
+    for (int y = 0; y < m->size; y++) {
+        for (int x = 0; x < m->size; x++) {
+            if (m->comp[cell_index(x, y)] == comp) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Carrega e resolve um mapa.
+ */
+void solve_map(int task) {
+    struct result *r = &results[task];
+    struct maze m;
+
+    double begin = now_seconds();
+    r->valid = maze_load(&m, map_paths[task]) == 0;
+    if (r->valid) {
+        r->path_length = maze_path_length(&m, m.entrance_x, m.entrance_y);
+        r->reachable = count_reachable(&m);
+    } else {
+        r->path_length = -1;
+        r->reachable = 0;
+    }
+    r->solve_us = (now_seconds() - begin) * 1e6;
+}
+
+/**
+ * @brief Retira uma tarefa do fim da própria fila.
+ *
+ * @return 1 se uma tarefa foi obtida, 0 se a fila está vazia.
+ */
+int deque_pop(struct deque *q, int *task) {
+    int found = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        *task = q->tasks[--q->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
+/**
+ * @brief Rouba uma tarefa do início da fila de outra thread.
+ *
+ * @return 1 se uma tarefa foi obtida, 0 se a fila está vazia.
+ */
+int deque_steal(struct deque *q, int *task) {
+    int found = 0;
+    pthread_mutex_lock(&q->lock);
+    if (q->head < q->tail) {
+        *task = q->tasks[q->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return found;
+}
+
+/**
+ * @brief Laço de uma thread de trabalho.
+ *
+ * Nenhuma tarefa é criada durante a execução, então a thread termina quando
+ * a própria fila e as de todas as outras estão vazias.
+ */
+void *worker_main(void *arg) {
+    struct worker *w = arg;
+    int task;
+
+    while (1) {
+        if (deque_pop(&w->queue, &task)) {
+            solve_map(task);
+            w->solved++;
+            continue;
+        }
+
+        // Fila vazia: procura trabalho nas outras threads
+        int found = 0;
+        for (int i = 1; i < nworkers && !found; i++) {
+            struct worker *victim = &workers[(w->id + i) % nworkers];
+            found = deque_steal(&victim->queue, &task);
+        }
+        if (!found) {
+            break;
+        }
+        solve_map(task);
+        w->solved++;
+        w->stolen++;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Escreve um campo de CSV, entre aspas se contiver vírgula, aspas ou
+ * quebra de linha (RFC 4180); as aspas do campo são duplicadas.
+ */
+void print_csv_field(FILE *out, const char *field) {
+    if (strpbrk(field, ",\"\r\n") == NULL) {
+        fputs(field, out);
+        return;
+    }
+    fputc('"', out);
+    for (const char *p = field; *p; p++) {
+        if (*p == '"') {
+            fputc('"', out);
+        }
+        fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+/**
+ * @brief Função principal do resolvedor em lote.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        usage(argc, argv);
+    }
+
+    const char *dir = argv[1];
+    nworkers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+    optind = 2;
+    while ((opt = getopt(argc, argv, "j:")) != -1) {
+        switch (opt) {
+        case 'j':
+            nworkers = atoi(optarg);
+            if (nworkers <= 0) {
+                usage(argc, argv);
+            }
+            break;
+        default:
+            usage(argc, argv);
+        }
+    }
+    if (nworkers <= 0) {
+        nworkers = 1;
+    }
+
+    int nmaps;
+    map_paths = list_maps(dir, &nmaps);
+    if (map_paths == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    results = calloc(nmaps > 0 ? nmaps : 1, sizeof(struct result));
+    workers = calloc(nworkers, sizeof(struct worker));
+    if (results == NULL || workers == NULL) {
+        logexit("calloc");
+    }
+
+    // Distribui os mapas entre as filas em blocos contíguos
+    for (int i = 0; i < nworkers; i++) {
+        struct worker *w = &workers[i];
+        int first = (int)((long long)nmaps * i / nworkers);
+        int last = (int)((long long)nmaps * (i + 1) / nworkers);
+        w->id = i;
+        w->queue.tasks = malloc((last - first + 1) * sizeof(int));
+        if (w->queue.tasks == NULL) {
+            logexit("malloc");
+        }
+        for (int t = first; t < last; t++) {
+            w->queue.tasks[w->queue.tail++] = t;
+        }
+        pthread_mutex_init(&w->queue.lock, NULL);
+    }
+
+    double begin = now_seconds();
+    for (int i = 0; i < nworkers; i++) {
+        if (pthread_create(&workers[i].thread, NULL, worker_main,
+                           &workers[i]) != 0) {
+            logexit("pthread_create");
+        }
+    }
+    int stolen = 0;
+    for (int i = 0; i < nworkers; i++) {
+        pthread_join(workers[i].thread, NULL);
+        stolen += workers[i].stolen;
+    }
+    double elapsed = now_seconds() - begin;
+
+    printf("map,valid,path_length,reachable_cells,solve_us\n");
+    int invalid = 0;
+    for (int i = 0; i < nmaps; i++) {
+        const struct result *r = &results[i];
+        print_csv_field(stdout, map_paths[i]);
+        printf(",%d,%d,%d,%.1f\n", r->valid, r->path_length, r->reachable,
+               r->solve_us);
+        invalid += !r->valid;
+    }
+    fprintf(stderr,
+            "solved %d maps (%d invalid) in %.3f s with %d threads, "
+            "%d stolen\n",
+            nmaps, invalid, elapsed, nworkers, stolen);
+
+    for (int i = 0; i < nworkers; i++) {
+        pthread_mutex_destroy(&workers[i].queue.lock);
+        free(workers[i].queue.tasks);
+    }
+    for (int i = 0; i < nmaps; i++) {
+        free(map_paths[i]);
+    }
+    free(map_paths);
+    free(results);
+    free(workers);
+    return 0;
+}
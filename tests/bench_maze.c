@@ -0,0 +1,92 @@
+/**
+ * @file bench_maze.c
+ * @brief Medição do custo das buscas no tabuleiro em cada layout.
+ *
+ * Gera labirintos aleatórios de tamanho máximo e mede o tempo do cálculo do
+ * campo de distâncias (BFS sobre maze_neighbor()) e da correção incremental
+ * ao trocar portas. Deve ser comparado entre os layouts (make bench e
+ * make bench LAYOUT=morton).
+ */
+#include "../maze.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Número de labirintos distintos
+#define MAZES 256
+// Repetições sobre todos os labirintos
+#define ROUNDS 2000
+
+/**
+ * @brief Obtém o instante atual em segundos (relógio monotônico).
+ */
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Gera um labirinto aleatório de tamanho máximo com portas.
+ */
+void random_maze(struct maze *m) {
+    memset(m, 0, sizeof(*m));
+    m->size = MAX_BOARD_SIZE;
+    for (int y = 0; y < m->size; y++) {
+        for (int x = 0; x < m->size; x++) {
+            int r = rand() % 10;
+            m->cells[cell_index(x, y)] = r < 3   ? WALL
+                                         : r < 9 ? PATH
+                                                 : DOOR_OPEN;
+        }
+    }
+    m->exit_cell = cell_index(rand() % m->size, rand() % m->size);
+    m->cells[m->exit_cell] = EXIT;
+}
+
+int main(void) {
+    static struct maze mazes[MAZES];
+    srand(1);
+    for (int i = 0; i < MAZES; i++) {
+        random_maze(&mazes[i]);
+    }
+
+    // Campo de distâncias completo
+    unsigned long checksum = 0;
+    double begin = now_seconds();
+    for (int round = 0; round < ROUNDS; round++) {
+        for (int i = 0; i < MAZES; i++) {
+            maze_build_distances(&mazes[i]);
+            checksum += mazes[i].dist[cell_index(0, 0)];
+        }
+    }
+    double build = now_seconds() - begin;
+
+    // Correção incremental: cada porta é fechada e reaberta
+    begin = now_seconds();
+    for (int round = 0; round < ROUNDS / 10; round++) {
+        for (int i = 0; i < MAZES; i++) {
+            struct maze *m = &mazes[i];
+            for (int c = 0; c < BOARD_CELLS; c++) {
+                if (m->cells[c] == DOOR_OPEN || m->cells[c] == DOOR_CLOSED) {
+                    maze_toggle_door(m, c);
+                    maze_toggle_door(m, c);
+                }
+            }
+            checksum += m->dist[cell_index(0, 0)];
+        }
+    }
+    double toggle = now_seconds() - begin;
+
+    printf("%s: build %.1f ns/maze, door repair %.1f us/maze (checksum %lu)\n",
+#ifdef BOARD_MORTON
+           "morton",
+#else
+           "rowmajor",
+#endif
+           build * 1e9 / ((double)ROUNDS * MAZES),
+           toggle * 1e6 / ((double)(ROUNDS / 10) * MAZES), checksum);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/**
+ * @file test_doors.c
+ * @brief Teste da correção incremental do campo de distâncias.
+ *
+ * Gera labirintos aleatórios com portas, troca portas ao acaso com
+ * maze_toggle_door() e, após cada troca, compara o campo de distâncias
+ * corrigido com o recalculado do zero por maze_build_distances(). Antes,
+ * confere maze_neighbor() com as coordenadas em todas as células. Deve ser
+ * executado nos dois layouts (make check e make check LAYOUT=morton).
+ */
+#include "../maze.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Número de labirintos gerados
+#define MAZES 50000
+// Trocas de portas por labirinto
+#define TOGGLES 30
+
+/**
+ * @brief Gera um labirinto aleatório com portas abertas e fechadas.
+ *
+ * @param m Labirinto a ser preenchido.
+ * @param doors Onde os índices das portas serão armazenados.
+ * @return Número de portas.
+ */
+int random_maze(struct maze *m, int *doors) {
+    memset(m, 0, sizeof(*m));
+    m->size = MIN_BOARD_SIZE + rand() % (MAX_BOARD_SIZE - MIN_BOARD_SIZE + 1);
+
+    int ndoors = 0;
+    for (int y = 0; y < m->size; y++) {
+        for (int x = 0; x < m->size; x++) {
+            int r = rand() % 10;
+            int value = r < 3   ? WALL
+                        : r < 8 ? PATH
+                                : (rand() % 2 ? DOOR_OPEN : DOOR_CLOSED);
+            m->cells[cell_index(x, y)] = value;
+            if (value == DOOR_OPEN || value == DOOR_CLOSED) {
+                doors[ndoors++] = cell_index(x, y);
+            }
+        }
+    }
+
+    m->exit_cell = cell_index(rand() % m->size, rand() % m->size);
+    m->cells[m->exit_cell] = EXIT;
+    maze_build_distances(m);
+    return ndoors;
+}
+
+/**
+ * @brief Compara maze_neighbor() com o vizinho calculado pelas coordenadas,
+ * em todas as células, direções e tamanhos de tabuleiro.
+ *
+ * @return 0 se todos coincidem, -1 caso contrário.
+ */
+int check_neighbors(void) {
+    struct maze m;
+    for (m.size = MIN_BOARD_SIZE; m.size <= MAX_BOARD_SIZE; m.size++) {
+        for (int y = 0; y < m.size; y++) {
+            for (int x = 0; x < m.size; x++) {
+                for (int dir = 0; dir < DIR_COUNT; dir++) {
+                    int nx = x + dir_dx[dir];
+                    int ny = y + dir_dy[dir];
+                    int expected = cell_index(nx, ny);
+                    if (nx < 0 || nx >= m.size || ny < 0 || ny >= m.size) {
+                        expected = -1;
+                    }
+                    if (maze_neighbor(&m, cell_index(x, y), dir) != expected) {
+                        printf("FAIL: size %d, cell (%d, %d), %s\n", m.size,
+                               x, y, dir_names[dir]);
+                        return -1;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(void) {
+    int doors[BOARD_CELLS];
+    srand(1);
+
+    if (check_neighbors() != 0) {
+        return EXIT_FAILURE;
+    }
+
+    for (int iter = 0; iter < MAZES; iter++) {
+        struct maze m;
+        int ndoors = random_maze(&m, doors);
+
+        for (int k = 0; k < TOGGLES && ndoors > 0; k++) {
+            int door = doors[rand() % ndoors];
+            if (m.cells[door] != DOOR_OPEN && m.cells[door] != DOOR_CLOSED) {
+                continue; // Sobrescrita pela saída
+            }
+            maze_toggle_door(&m, door);
+
+            struct maze ref = m;
+            maze_build_distances(&ref);
+            for (int i = 0; i < BOARD_CELLS; i++) {
+                if (maze_walkable(&m, i) && ref.dist[i] != m.dist[i]) {
+                    printf("FAIL: maze %d, toggle %d, cell (%d, %d): "
+                           "distance %d, expected %d\n",
+                           iter, k, cell_x(i), cell_y(i), m.dist[i],
+                           ref.dist[i]);
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+    }
+
+    printf("test_doors: %d mazes ok\n", MAZES);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file timer.c
+ * @brief Implementação da roda de temporizadores hierárquica.
+ */
+#include "timer.h"
+
+#include <stddef.h>
+
+// Maior intervalo representável na roda, em ticks
+#define TIMER_MAX_DELTA ((1ull << (TIMER_BITS * TIMER_LEVELS)) - 1)
+
+/**
+ * @brief Coloca o temporizador na posição correspondente ao tempo que falta.
+ */
+static void timer_place(struct timer_wheel *w, struct timer *t) {
+    uint64_t delta = t->expires - w->now;
+    int level = 0;
+    while (level < TIMER_LEVELS - 1 &&
+           delta >= (1ull << (TIMER_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = (t->expires >> (TIMER_BITS * level)) & (TIMER_SLOTS - 1);
+
+    struct timer **head = &w->slots[level][slot];
+    t->next = *head;
+    if (*head) {
+        (*head)->pprev = &t->next;
+    }
+    *head = t;
+    t->pprev = head;
+}
+
+/**
+ * @brief Retira o temporizador da sua posição.
+ */
+static void timer_unlink(struct timer *t) {
+    *t->pprev = t->next;
+    if (t->next) {
+        t->next->pprev = t->pprev;
+    }
+    t->next = NULL;
+    t->pprev = NULL;
+}
+
+void timer_add(struct timer_wheel *w, struct timer *t, uint64_t ticks) {
+    timer_cancel(w, t);
+    if (ticks == 0) {
+        ticks = 1;
+    } else if (ticks > TIMER_MAX_DELTA) {
+        ticks = TIMER_MAX_DELTA;
+    }
+    t->expires = w->now + ticks;
+    timer_place(w, t);
+    w->pending++;
+}
+
+void timer_cancel(struct timer_wheel *w, struct timer *t) {
+    if (t->pprev) {
+        timer_unlink(t);
+        w->pending--;
+    }
+}
+
+/**
+ * @brief Redistribui os temporizadores de uma posição de um nível superior.
+ */
+static void timer_cascade(struct timer_wheel *w, int level) {
+    int slot = (w->now >> (TIMER_BITS * level)) & (TIMER_SLOTS - 1);
+    struct timer *t = w->slots[level][slot];
+    w->slots[level][slot] = NULL;
+    while (t) {
+        struct timer *next = t->next;
+        timer_place(w, t);
+        t = next;
+    }
+}
+
+void timer_advance(struct timer_wheel *w, uint64_t now) {
+    if (w->pending == 0 && now > w->now) {
+        w->now = now;
+        return;
+    }
+
+    while (w->now < now) {
+        w->now++;
+
+        // Ao começar um novo intervalo de um nível, seus temporizadores descem
+        for (int level = 1; level < TIMER_LEVELS; level++) {
+            if ((w->now & ((1ull << (TIMER_BITS * level)) - 1)) != 0) {
+                break;
+            }
+            timer_cascade(w, level);
+        }
+
+        struct timer **head = &w->slots[0][w->now & (TIMER_SLOTS - 1)];
+        while (*head) {
+            struct timer *t = *head;
+            timer_unlink(t);
+            w->pending--;
+            t->fn(t);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file timer.h
+ * @brief Arquivo de cabeçalho da roda de temporizadores hierárquica.
+ *
+ * A roda guarda temporizadores intrusivos (embutidos nas estruturas que os
+ * usam) em TIMER_LEVELS níveis de TIMER_SLOTS posições. O nível 0 tem
+ * resolução de um tick; cada nível seguinte cobre TIMER_SLOTS vezes o
+ * intervalo do anterior, e seus temporizadores descem de nível quando o
+ * intervalo correspondente começa. Inserir, cancelar e disparar custam O(1)
+ * por temporizador, sem chamadas ao sistema, qualquer que seja o número de
+ * temporizadores pendentes.
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Bits do índice de cada nível
+#define TIMER_BITS 8
+// Posições em cada nível
+#define TIMER_SLOTS (1 << TIMER_BITS)
+// Número de níveis (alcance de 2^32 ticks)
+#define TIMER_LEVELS 4
+
+struct timer;
+
+// Função chamada quando o temporizador vence
+typedef void (*timer_fn)(struct timer *t);
+
+/**
+ * @brief Temporizador embutido na estrutura que o usa.
+ *
+ * Deve começar zerado; um temporizador está pendente enquanto pprev não for
+ * NULL.
+ */
+struct timer {
+    struct timer *next;
+    struct timer **pprev; // Ponteiro que aponta para este temporizador
+    uint64_t expires;     // Tick em que o temporizador vence
+    timer_fn fn;
+    void *arg;            // Dado livre para a função
+};
+
+/**
+ * @brief Roda de temporizadores.
+ */
+struct timer_wheel {
+    uint64_t now;         // Tick atual
+    unsigned long pending; // Temporizadores pendentes
+    struct timer *slots[TIMER_LEVELS][TIMER_SLOTS];
+};
+
+/**
+ * @brief Agenda um temporizador para daqui a ticks ticks (no mínimo 1).
+ *
+ * Se o temporizador já estiver pendente, ele é reagendado.
+ */
+void timer_add(struct timer_wheel *w, struct timer *t, uint64_t ticks);
+
+/**
+ * @brief Cancela um temporizador, se estiver pendente.
+ */
+void timer_cancel(struct timer_wheel *w, struct timer *t);
+
+/**
+ * @brief Avança a roda até o tick now, disparando os temporizadores vencidos.
+ *
+ * As funções chamadas podem agendar e cancelar temporizadores. Instantes
+ * anteriores ao tick atual são ignorados; sem temporizadores pendentes, a
+ * roda salta direto para now.
+ */
+void timer_advance(struct timer_wheel *w, uint64_t now);